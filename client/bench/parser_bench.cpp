@@ -0,0 +1,124 @@
+/*
+ * Rejoue un flux capturé depuis le serveur (bench/server_stream.txt) à travers
+ * l'ancien découpage (find/substr/erase + parse_input) et le nouveau
+ * (RecvBuffer + parse_line sur des string_view), par blocs de 4096 octets comme
+ * le thread réseau.
+ *
+ * Usage : ./parser_bench [flux] [Mo à rejouer]
+ */
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "protocol.hpp"
+
+using namespace std;
+
+constexpr size_t CHUNK = 4096;
+
+struct Result {
+	double seconds;
+	size_t messages;
+	size_t fields; // Somme de contrôle : les deux analyseurs doivent trouver les mêmes champs
+};
+
+// Ancienne boucle du thread réseau
+static Result run_old(const string& stream) {
+	auto start = chrono::steady_clock::now();
+	Result result{0, 0, 0};
+	string recv_buffer;
+
+	for (size_t offset = 0; offset < stream.size(); offset += CHUNK) {
+		recv_buffer.append(stream, offset, CHUNK);
+
+		size_t pos;
+		while ((pos = recv_buffer.find('\n')) != string::npos) {
+			string line = recv_buffer.substr(0, pos);
+			recv_buffer.erase(0, pos + 1);
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+
+			auto cmd = parse_input(line);
+			if (!cmd) continue;
+			result.messages++;
+			result.fields += cmd->params.size();
+		}
+	}
+
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+// Nouvelle boucle : copie du bloc complet (comme le lot transmis à l'interface), puis vues
+static Result run_new(const string& stream) {
+	auto start = chrono::steady_clock::now();
+	Result result{0, 0, 0};
+	RecvBuffer recv_buffer;
+	CommandView cmd;
+
+	for (size_t offset = 0; offset < stream.size(); offset += CHUNK) {
+		size_t len = min(CHUNK, stream.size() - offset);
+		memcpy(recv_buffer.prepare(len), stream.data() + offset, len);
+		recv_buffer.commit(len);
+
+		string_view unread = recv_buffer.unread();
+		long complete = complete_prefix(unread.data(), unread.size(), false);
+		if (complete <= 0) continue;
+
+		string block(unread.substr(0, complete));
+		recv_buffer.consume(complete);
+
+		string_view rest = block;
+		while (!rest.empty()) {
+			size_t newline = rest.find('\n');
+			string_view line = rest.substr(0, newline);
+			rest.remove_prefix(newline == string_view::npos ? rest.size() : newline + 1);
+
+			if (!parse_line(line, cmd)) continue;
+			result.messages++;
+			result.fields += cmd.params.size();
+		}
+	}
+
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+static void report(const char* name, const Result& result, size_t bytes) {
+	cout << name << " : " << result.messages << " messages, "
+		<< result.seconds * 1e9 / result.messages << " ns/message, "
+		<< bytes / result.seconds / (1 << 20) << " Mo/s" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	const char* path = argc > 1 ? argv[1] : "bench/server_stream.txt";
+	size_t target_mb = argc > 2 ? stoul(argv[2]) : 64;
+
+	ifstream file(path, ios::binary);
+	if (!file) {
+		cerr << "Impossible de lire " << path << endl;
+		return 1;
+	}
+	stringstream capture;
+	capture << file.rdbuf();
+
+	// Le flux capturé est répété pour simuler une longue session (ou une rafale)
+	string stream;
+	while (stream.size() < target_mb << 20) {
+		stream += capture.str();
+	}
+
+	Result old_result = run_old(stream);
+	Result new_result = run_new(stream);
+
+	report("Ancien", old_result, stream.size());
+	report("Nouveau", new_result, stream.size());
+	if (old_result.messages != new_result.messages || old_result.fields != new_result.fields) {
+		cerr << "Résultats différents entre les deux analyseurs" << endl;
+		return 1;
+	}
+	cout << "Accélération : x" << old_result.seconds / new_result.seconds << endl;
+	return 0;
+}
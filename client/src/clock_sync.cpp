@@ -0,0 +1,37 @@
+#include "clock_sync.hpp"
+
+using namespace std;
+
+int64_t ClockSync::local_ms(time_point t) {
+	return chrono::duration_cast<chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+ClockSync::time_point ClockSync::from_local_ms(int64_t ms) {
+	return time_point(chrono::milliseconds(ms));
+}
+
+void ClockSync::add_sample(int64_t sent, int64_t server, int64_t received) {
+	if (received < sent) return;
+
+	int64_t rtt = received - sent;
+	srtt_ = count_ == 0 ? rtt : (7 * srtt_ + rtt) / 8;
+	last_rtt_ = rtt;
+
+	samples_[next_] = {rtt, server - (sent + rtt / 2)};
+	next_ = (next_ + 1) % samples_.size();
+	if (count_ < samples_.size()) count_++;
+
+	const Sample* best = &samples_[0];
+	for (size_t i = 1; i < count_; i++) {
+		if (samples_[i].rtt < best->rtt) best = &samples_[i];
+	}
+	offset_ = best->offset;
+}
+
+void ClockSync::reset() {
+	*this = ClockSync();
+}
+
+ClockSync::time_point ClockSync::to_local(int64_t server_ms) const {
+	return from_local_ms(server_ms - offset_);
+}
@@ -0,0 +1,46 @@
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+constexpr std::chrono::seconds PING_INTERVAL{5}; // Période des /ping envoyés au serveur
+constexpr size_t CLOCK_SAMPLES = 8;              // Mesures gardées pour l'estimation
+
+// Décalage entre l'horloge du serveur (ms, cf. server/include/latency.h) et steady_clock,
+// estimé par les échanges "/ping T" -> "/pong T:HEURE_SERVEUR". Comme NTP, on retient
+// parmi les dernières mesures celle au plus court aller-retour : c'est la moins
+// faussée par les files d'attente, et l'heure du serveur y est prise au milieu.
+class ClockSync {
+public:
+	using time_point = std::chrono::steady_clock::time_point;
+
+	static int64_t local_ms(time_point t);
+	static time_point from_local_ms(int64_t ms);
+
+	// sent et received en local_ms, server dans l'horloge du serveur
+	void add_sample(int64_t sent, int64_t server, int64_t received);
+	void reset();
+
+	bool synced() const { return count_ > 0; }
+	time_point to_local(int64_t server_ms) const;
+
+	int64_t last_rtt() const { return last_rtt_; }
+	int64_t smoothed_rtt() const { return srtt_; } // Moyenne glissante (1/8), comme TCP
+
+private:
+	struct Sample {
+		int64_t rtt;
+		int64_t offset; // Horloge du serveur - horloge locale
+	};
+	std::array<Sample, CLOCK_SAMPLES> samples_{};
+	size_t next_ = 0;
+	size_t count_ = 0;
+	int64_t offset_ = 0;
+	int64_t last_rtt_ = 0;
+	int64_t srtt_ = 0;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include "event_log.hpp"
+
+using namespace std;
+
+EventLog::EventLog(size_t capacity) : ring_(capacity ? capacity : 1) {}
+
+EventLog::~EventLog() {
+	if (!spill_) return;
+
+	// Le reste du journal rejoint le fichier à la fermeture
+	for (size_t i = 0; i < count_; i++) {
+		fprintf(spill_, "%s\n", at(i).c_str());
+	}
+	fclose(spill_);
+}
+
+bool EventLog::open_spill(const string& path) {
+	FILE* file = fopen(path.c_str(), "a");
+	if (!file) return false;
+	if (spill_) fclose(spill_);
+	spill_ = file;
+	return true;
+}
+
+void EventLog::push(string entry) {
+	if (count_ == ring_.size()) {
+		// Plein : la plus ancienne entrée quitte la mémoire (écriture bufferisée par stdio)
+		if (spill_) fprintf(spill_, "%s\n", ring_[head_].c_str());
+		ring_[head_] = move(entry);
+		head_ = (head_ + 1) % ring_.size();
+	} else {
+		ring_[(head_ + count_) % ring_.size()] = move(entry);
+		count_++;
+	}
+	total_++;
+}
+
+const string& EventLog::at(size_t i) const {
+	return ring_[(head_ + i) % ring_.size()];
+}
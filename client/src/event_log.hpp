@@ -0,0 +1,37 @@
+#ifndef EVENT_LOG_HPP
+#define EVENT_LOG_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Nombre d'entrées gardées en mémoire
+constexpr size_t EVENT_LOG_CAPACITY = 1024;
+
+// Journal des événements à capacité fixe : les entrées les plus anciennes sont
+// écrasées, et recopiées au passage dans un fichier de débordement s'il est ouvert.
+class EventLog {
+public:
+	explicit EventLog(size_t capacity = EVENT_LOG_CAPACITY);
+	~EventLog();
+
+	EventLog(const EventLog&) = delete;
+	EventLog& operator=(const EventLog&) = delete;
+
+	bool open_spill(const std::string& path);
+	void push(std::string entry);
+
+	size_t size() const { return count_; }
+	uint64_t total() const { return total_; }        // Entrées ajoutées depuis le début
+	const std::string& at(size_t i) const;            // 0 : la plus ancienne encore en mémoire
+
+private:
+	std::vector<std::string> ring_;
+	size_t head_ = 0;  // Emplacement de la plus ancienne entrée
+	size_t count_ = 0;
+	uint64_t total_ = 0;
+	FILE* spill_ = nullptr;
+};
+
+#endif
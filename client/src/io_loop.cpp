@@ -0,0 +1,210 @@
+#include "io_loop.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+IoLoop::IoLoop() {
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (epoll_fd_ >= 0 && wake_fd_ >= 0) {
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = wake_fd_;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+	}
+}
+
+IoLoop::~IoLoop() {
+	// Coroutines encore suspendues à l'arrêt : leur cadre est libéré ici
+	for (auto& [fd, waiters] : fds_) {
+		if (waiters.reader) waiters.reader->handle.destroy();
+		if (waiters.writer) waiters.writer->handle.destroy();
+	}
+	for (auto& [at, handle] : timers_) handle.destroy();
+	for (auto handle : notified_) handle.destroy();
+	for (auto handle : ready_) handle.destroy();
+
+	if (epoll_fd_ >= 0) close(epoll_fd_);
+	if (wake_fd_ >= 0) close(wake_fd_);
+}
+
+void IoLoop::notify() {
+	uint64_t one = 1;
+	if (write(wake_fd_, &one, sizeof(one)) < 0) {
+		// eventfd déjà signalé : rien à faire
+	}
+}
+
+void IoLoop::stop() {
+	stop_ = true;
+	notify();
+}
+
+void IoLoop::FdAwaiter::await_suspend(coroutine_handle<> h) {
+	handle = h;
+	loop.watch(this);
+}
+
+void IoLoop::watch(FdAwaiter* awaiter) {
+	FdWaiters& waiters = fds_[awaiter->fd];
+	(awaiter->write ? waiters.writer : waiters.reader) = awaiter;
+	update_interest(awaiter->fd, waiters);
+}
+
+void IoLoop::update_interest(int fd, FdWaiters& waiters) {
+	struct epoll_event ev = {};
+	ev.events = (waiters.reader ? EPOLLIN : 0) | (waiters.writer ? EPOLLOUT : 0);
+	ev.data.fd = fd;
+
+	if (!ev.events) {
+		if (waiters.registered) epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+		fds_.erase(fd);
+		return;
+	}
+	epoll_ctl(epoll_fd_, waiters.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+	waiters.registered = true;
+}
+
+void IoLoop::cancel(int fd) {
+	auto it = fds_.find(fd);
+	if (it == fds_.end()) return;
+
+	for (FdAwaiter* awaiter : {it->second.reader, it->second.writer}) {
+		if (!awaiter) continue;
+		awaiter->ready = false;
+		ready_.push_back(awaiter->handle);
+	}
+	if (it->second.registered) epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+	fds_.erase(it);
+}
+
+int IoLoop::next_timeout() const {
+	if (!ready_.empty()) return 0;
+	if (timers_.empty()) return -1;
+	auto left = chrono::duration_cast<chrono::milliseconds>(timers_.begin()->first - clock::now()).count();
+	return static_cast<int>(clamp<long long>(left + 1, 0, 60000));
+}
+
+void IoLoop::run(const function<void()>& start) {
+	start();
+
+	struct epoll_event events[16];
+	while (!stop_) {
+		int n = epoll_wait(epoll_fd_, events, 16, next_timeout());
+		if (n < 0 && errno != EINTR) break;
+
+		vector<coroutine_handle<>> resume;
+		resume.swap(ready_);
+
+		for (int i = 0; i < n; i++) {
+			int fd = events[i].data.fd;
+			if (fd == wake_fd_) {
+				uint64_t count;
+				if (read(wake_fd_, &count, sizeof(count)) < 0) {
+					// Déjà vidé
+				}
+				resume.insert(resume.end(), notified_.begin(), notified_.end());
+				notified_.clear();
+				continue;
+			}
+
+			auto it = fds_.find(fd);
+			if (it == fds_.end()) continue;
+			FdWaiters& waiters = it->second;
+			uint32_t happened = events[i].events;
+			bool failed = happened & (EPOLLERR | EPOLLHUP);
+
+			// L'erreur est rendue à la lecture ou à l'écriture suivante
+			if (waiters.reader && (happened & EPOLLIN || failed)) {
+				waiters.reader->ready = true;
+				resume.push_back(waiters.reader->handle);
+				waiters.reader = nullptr;
+			}
+			if (waiters.writer && (happened & EPOLLOUT || failed)) {
+				waiters.writer->ready = true;
+				resume.push_back(waiters.writer->handle);
+				waiters.writer = nullptr;
+			}
+			update_interest(fd, waiters);
+		}
+
+		auto now = clock::now();
+		while (!timers_.empty() && timers_.begin()->first <= now) {
+			resume.push_back(timers_.begin()->second);
+			timers_.erase(timers_.begin());
+		}
+
+		for (auto handle : resume) {
+			if (stop_) {
+				ready_.push_back(handle); // Détruit avec la boucle
+				continue;
+			}
+			handle.resume();
+		}
+	}
+}
+
+WaitSet::WaitSet() {
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (valid()) {
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = timer_fd_;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev);
+	}
+}
+
+WaitSet::~WaitSet() {
+	if (epoll_fd_ >= 0) close(epoll_fd_);
+	if (timer_fd_ >= 0) close(timer_fd_);
+}
+
+void WaitSet::watch(int fd, uint32_t events) {
+	struct epoll_event ev = {};
+	ev.events = events;
+	ev.data.fd = fd;
+
+	bool known = find(watched_.begin(), watched_.end(), fd) != watched_.end();
+	epoll_ctl(epoll_fd_, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+	if (!known) watched_.push_back(fd);
+}
+
+void WaitSet::unwatch(int fd) {
+	auto it = find(watched_.begin(), watched_.end(), fd);
+	if (it == watched_.end()) return;
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+	watched_.erase(it);
+}
+
+// CLOCK_MONOTONIC est l'horloge de steady_clock sous Linux : l'échéance est absolue
+void WaitSet::arm(IoLoop::clock::time_point at) {
+	auto since_epoch = chrono::duration_cast<chrono::nanoseconds>(at.time_since_epoch()).count();
+	struct itimerspec spec = {};
+	spec.it_value.tv_sec = since_epoch / 1000000000;
+	spec.it_value.tv_nsec = since_epoch % 1000000000;
+	if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) spec.it_value.tv_nsec = 1; // 0 désarmerait
+	timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+vector<WaitSet::Ready> WaitSet::collect(bool& expired) {
+	expired = false;
+	vector<Ready> ready;
+	struct epoll_event events[16];
+	int n = epoll_wait(epoll_fd_, events, 16, 0);
+	for (int i = 0; i < n; i++) {
+		if (events[i].data.fd != timer_fd_) {
+			ready.push_back({events[i].data.fd, events[i].events});
+			continue;
+		}
+		uint64_t count;
+		if (read(timer_fd_, &count, sizeof(count)) > 0) expired = true;
+	}
+	return ready;
+}
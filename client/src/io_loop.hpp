@@ -0,0 +1,185 @@
+#ifndef IO_LOOP_HPP
+#define IO_LOOP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Coroutine détachée, lancée depuis le thread de la boucle : elle s'exécute jusqu'à
+ * sa première attente, et son cadre est libéré à la fin. Une coroutine n'en attend
+ * jamais une autre : chaque cadre suspendu est dans une seule attente de la boucle,
+ * qui le détruit elle-même s'il l'est encore à l'arrêt.
+ */
+struct IoTask {
+	struct promise_type {
+		IoTask get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+/*
+ * Boucle d'événements d'un seul thread, sur epoll : attente d'un descripteur
+ * (lecture ou écriture), d'une échéance, ou d'une notification venue d'un autre
+ * thread (eventfd). Seuls notify() et stop() peuvent être appelés hors de ce thread.
+ */
+class IoLoop {
+public:
+	using clock = std::chrono::steady_clock;
+
+	IoLoop();
+	~IoLoop();
+
+	IoLoop(const IoLoop&) = delete;
+	IoLoop& operator=(const IoLoop&) = delete;
+
+	bool valid() const { return epoll_fd_ >= 0 && wake_fd_ >= 0; }
+	void run(const std::function<void()>& start); // start lance les coroutines, dans le thread de la boucle
+	void stop();
+	void notify();
+	bool stopping() const { return stop_; }
+
+	// Résultat false : l'attente a été annulée par cancel(fd)
+	struct FdAwaiter {
+		IoLoop& loop;
+		int fd;
+		bool write;
+		bool ready = false;
+		std::coroutine_handle<> handle;
+
+		bool await_ready() const { return fd < 0; }
+		void await_suspend(std::coroutine_handle<> h);
+		bool await_resume() const { return ready; }
+	};
+
+	struct TimerAwaiter {
+		IoLoop& loop;
+		clock::time_point at;
+
+		bool await_ready() const { return clock::now() >= at; }
+		void await_suspend(std::coroutine_handle<> h) { loop.timers_.emplace(at, h); }
+		void await_resume() const {}
+	};
+
+	struct NotifyAwaiter {
+		IoLoop& loop;
+
+		bool await_ready() const { return false; }
+		void await_suspend(std::coroutine_handle<> h) { loop.notified_.push_back(h); }
+		void await_resume() const {}
+	};
+
+	FdAwaiter readable(int fd) { return {*this, fd, false}; }
+	FdAwaiter writable(int fd) { return {*this, fd, true}; }
+	TimerAwaiter sleep_until(clock::time_point at) { return {*this, at}; }
+	TimerAwaiter sleep_for(clock::duration delay) { return {*this, clock::now() + delay}; }
+	NotifyAwaiter notified() { return {*this}; }
+
+	// À appeler avant de fermer fd : les coroutines qui l'attendent reprennent avec false
+	void cancel(int fd);
+
+private:
+	struct FdWaiters {
+		FdAwaiter* reader = nullptr;
+		FdAwaiter* writer = nullptr;
+		bool registered = false;
+	};
+
+	void watch(FdAwaiter* awaiter);
+	void update_interest(int fd, FdWaiters& waiters);
+	int next_timeout() const;
+
+	int epoll_fd_ = -1;
+	int wake_fd_ = -1;
+	std::atomic<bool> stop_{false};
+	std::unordered_map<int, FdWaiters> fds_;
+	std::multimap<clock::time_point, std::coroutine_handle<>> timers_;
+	std::vector<std::coroutine_handle<>> notified_;
+	std::vector<std::coroutine_handle<>> ready_; // À reprendre au prochain tour (annulations)
+};
+
+/*
+ * Attente groupée d'une coroutine : plusieurs descripteurs et une échéance, que la
+ * boucle voit comme un seul (epoll imbriqué et timerfd). Après `co_await loop.readable(fd())`,
+ * collect() dit lesquels sont prêts et si l'échéance est passée.
+ */
+class WaitSet {
+public:
+	WaitSet();
+	~WaitSet();
+
+	WaitSet(const WaitSet&) = delete;
+	WaitSet& operator=(const WaitSet&) = delete;
+
+	bool valid() const { return epoll_fd_ >= 0 && timer_fd_ >= 0; }
+	int fd() const { return epoll_fd_; }
+	void watch(int fd, uint32_t events); // Ajoute fd, ou remplace ses événements
+	void unwatch(int fd);
+	void arm(IoLoop::clock::time_point at);
+
+	struct Ready {
+		int fd;
+		uint32_t events;
+	};
+	std::vector<Ready> collect(bool& expired);
+
+private:
+	int epoll_fd_ = -1;
+	int timer_fd_ = -1;
+	std::vector<int> watched_;
+};
+
+/*
+ * File sans verrou à producteurs multiples et consommateur unique (Vyukov) :
+ * push() depuis n'importe quel thread, pop() uniquement depuis la boucle.
+ */
+template <typename T>
+class MpscQueue {
+public:
+	MpscQueue() : head_(new Node), tail_(head_.load()) {}
+	~MpscQueue() {
+		T value;
+		while (pop(value)) {}
+		delete tail_;
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	void push(T value) {
+		Node* node = new Node;
+		node->value = std::move(value);
+		Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	bool pop(T& out) {
+		Node* next = tail_->next.load(std::memory_order_acquire);
+		if (!next) return false;
+		out = std::move(next->value);
+		delete tail_;
+		tail_ = next;
+		return true;
+	}
+
+private:
+	struct Node {
+		std::atomic<Node*> next{nullptr};
+		T value{};
+	};
+
+	std::atomic<Node*> head_; // Dernier nœud ajouté (producteurs)
+	Node* tail_;              // Nœud déjà consommé qui précède le prochain (consommateur)
+};
+
+#endif
@@ -23,6 +23,15 @@
 #include "ftxui/screen/string.hpp"
 #include "ftxui/dom/node.hpp"  
 #include "ftxui/screen/color.hpp"  
+#include "ftxui/screen/terminal.hpp"
+
+#include "net.hpp"
+#include "protocol.hpp"
+#include "event_log.hpp"
+#include "players.hpp"
+#include "clock_sync.hpp"
+#include "recorder.hpp"
+#include "io_loop.hpp"
 
 #include <sstream>
 #include <memory>
@@ -30,6 +39,10 @@
 #include <cctype>
 #include <chrono>
 #include <deque>
+#include <charconv>
+#include <string_view>
+#include <condition_variable>
+#include <random>
 
 using namespace std;
 using namespace ftxui;
@@ -55,16 +68,11 @@ enum GAME_STATE {
 }; 
 
 // Structures et variables globales
-struct Command {
-	string command;
-	vector<string> params;
-};
-
 struct GameData {
 	mutex mtx;
 	string server_id;
-	deque<string> game_log;
-	vector<tuple<string, vector<string>, string>> players;
+	EventLog game_log;
+	PlayerList players;
 	string current_word;
 	string current_login;
 	string current_player;
@@ -72,313 +80,807 @@ struct GameData {
 	string impostor_word;
 	string common_word;
 	string rounds;
-	int players_count = 0;
+	vector<pair<string, string>> leaderboard; // Classement global : (joueur, score)
+	string leaderboard_total;
+	string my_rank;
+	bool player_ids = false;    // Le serveur désigne les joueurs par identifiant (/info ROSTER reçu)
+	bool ids_requested = false; // "/proto ID" envoyé, sans réponse pour l'instant
 	bool game_active = false;
 	GAME_STATE game_state = WAITING_USERNAME;
-	std::chrono::time_point<std::chrono::steady_clock> play_start_time;
+	std::chrono::time_point<std::chrono::steady_clock> play_deadline;
 	int play_duration_seconds = 30; // Durée du timer en secondes
+	ClockSync clock;                // Horloge du serveur, pour les échéances de /play et /choice
 	bool timer_active = false;
 	bool show_splash = true; // Contrôle l'affichage du splash screen
 	std::chrono::time_point<std::chrono::steady_clock> splash_start_time;
+	condition_variable changed; // Réveille le planificateur de rafraîchissement
+	uint64_t generation = 0;    // Incrémenté à chaque modification visible
+
+	// Versions des données dont le rendu est mis en cache (cf. RenderCache)
+	uint64_t leaderboard_version = 0; // (joueurs : players.version(), journal : game_log.total())
 };
 
-std::string to_lowercase(const std::string& str) {
-	std::string lower_str = str;
+void log_event(GameData& game_data, string entry) {
+	game_data.game_log.push(move(entry));
+}
+
+// À appeler sous game_data.mtx après toute modification de l'état affiché
+void mark_dirty(GameData& game_data) {
+	game_data.generation++;
+	game_data.changed.notify_one();
+}
+
+std::string to_lowercase(std::string_view str) {
+	std::string lower_str(str);
 	std::transform(lower_str.begin(), lower_str.end(), lower_str.begin(),
 				[](unsigned char c) { return std::tolower(c); });
 	return lower_str;
 }
 
-unique_ptr<Command> parse_input(const string& input) {
-	if (input.empty() || input[0] != '/') return nullptr;
+atomic<int> shift{0}; // Image courante des spinners (avancée par le planificateur)
 
-	auto cmd = make_unique<Command>();
-	size_t space_pos = input.find(' ');
-	if (space_pos == string::npos) {
-		cmd->command = input;
-		return cmd;
-	}
+// Protocole binaire négocié avec le serveur (renégocié par le thread réseau à chaque reconnexion)
+atomic<bool> binary_protocol{false};
 
-	cmd->command = input.substr(0, space_pos);
-	string rest = input.substr(space_pos + 1);
-	stringstream ss(rest);
-	string segment;
+// Flux brut reçu, enregistré avec -R (écrit uniquement par le thread réseau une fois lancé)
+StreamRecorder stream_recorder;
 
-	while (getline(ss, segment, ':')) {
-		segment.erase(segment.begin(), find_if(segment.begin(), segment.end(), [](unsigned char ch) {
-			return !isspace(ch);
-		}));
-		segment.erase(find_if(segment.rbegin(), segment.rend(), [](unsigned char ch) {
-			return !isspace(ch);
-		}).base(), segment.end());
+// Thread réseau : une boucle epoll et ses coroutines (lecture, écriture, ping, rejeu)
+IoLoop io_loop;
 
-		if (!segment.empty()) {
-			cmd->params.push_back(segment);
-		}
-	}
+// Messages encodés en attente d'envoi, déposés par n'importe quel thread
+MpscQueue<string> outbox;
 
-	return cmd;
+// Ne bloque jamais : le message est confié au thread réseau, qui l'écrira dès que possible
+void send_message(const Command& cmd) {
+	outbox.push(binary_protocol ? encode_binary(cmd) : encode_text(cmd));
+	io_loop.notify();
 }
 
-int shift = 0;
-
-int connect_to_server(const string& host, int port) {
-	int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-	if (sockfd < 0) return -1;
-
-	struct hostent* server = gethostbyname(host.c_str());
-	if (server == nullptr) {
-		close(sockfd);
-		return -1;
-	}
-
-	struct sockaddr_in serv_addr;
-	memset(&serv_addr, 0, sizeof(serv_addr));
-	serv_addr.sin_family = AF_INET;
-	memcpy(&serv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
-	serv_addr.sin_port = htons(port);
+// Envoi direct, pendant la négociation (socket encore bloquante, boucle pas à l'écoute)
+static void write_message(Connection& conn, const Command& cmd) {
+	string msg = binary_protocol ? encode_binary(cmd) : encode_text(cmd);
+	conn.write_all(msg.data(), msg.size());
+}
 
-	if (connect(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
-		close(sockfd);
-		return -1;
+/*
+ * Cherche l'acquittement de "/proto BIN" dans les lignes texte complètes de `buffer`.
+ * Les lignes qui le précèdent sont rangées dans `early` ; ce qui le suit (déjà binaire)
+ * reste dans `buffer`. Retourne true une fois la réponse trouvée.
+ */
+static bool take_proto_answer(string& buffer, string& early, bool& accepted) {
+	size_t pos;
+	while ((pos = buffer.find('\n')) != string::npos) {
+		string line = buffer.substr(0, pos);
+		buffer.erase(0, pos + 1);
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		auto cmd = parse_input(line);
+		if (!cmd) continue;
+		if (cmd->command == "/ret" && !cmd->params.empty() && cmd->params[0] == "PROTO") {
+			accepted = cmd->params.size() >= 2 && cmd->params[1] == "000";
+			return true;
+		}
+		early += line + "\n";
 	}
-
-	return sockfd;
+	return false;
 }
 
-void send_message(int sockfd, const string& message) {
-	if (!message.empty()) {
-		string msg = message + "\n";
-		write(sockfd, msg.c_str(), msg.size());
+constexpr auto NEGOTIATE_TIMEOUT = chrono::seconds(3);
+
+/*
+ * Demande le protocole binaire ("/proto BIN") avant le démarrage de l'interface.
+ * Les lignes texte reçues avant l'acquittement sont rangées dans `early`,
+ * les octets qui le suivent (déjà binaires) dans `leftover`.
+ */
+bool negotiate_binary(Connection& conn, string& early, string& leftover) {
+	struct timeval timeout = {NEGOTIATE_TIMEOUT.count(), 0};
+	setsockopt(conn.fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	write_message(conn, Command{"/proto", {"BIN"}});
+
+	string buffer;
+	bool accepted = false;
+	while (true) {
+		char chunk[1024];
+		int n = conn.read(chunk, sizeof(chunk));
+		if (n <= 0) break;
+		buffer.append(chunk, n);
+		if (take_proto_answer(buffer, early, accepted)) break;
 	}
+
+	timeout = {0, 0};
+	setsockopt(conn.fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	leftover = buffer;
+	return accepted;
 }
 
 int get_remaining_time(const GameData& game_data) {
 	if (!game_data.timer_active) return 0;
 	
 	auto now = std::chrono::steady_clock::now();
-	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-		now - game_data.play_start_time).count();
+	auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+		game_data.play_deadline - now).count();
 	
-	int remaining = game_data.play_duration_seconds - static_cast<int>(elapsed);
-	return std::max(0, remaining); // Ne pas retourner de valeur négative
+	return std::max<int>(0, (left + 999) / 1000); // Secondes entamées, jamais négatif
 }
 
-void handle_server_messages(int sockfd, GameData& game_data, ScreenInteractive& screen, atomic<bool>& running) {
-	string recv_buffer;
+// Concatène des morceaux de texte en une seule allocation
+template <typename... Parts>
+string concat(const Parts&... parts) {
+	string result;
+	result.reserve((string_view(parts).size() + ...));
+	(result.append(string_view(parts)), ...);
+	return result;
+}
 
-	while (running) {
-		char buffer[1024];
-		int n = read(sockfd, buffer, sizeof(buffer));
-		if (n < 0) {
-			if (errno == EAGAIN || errno == EWOULDBLOCK) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				continue; // Attendre un peu et réessayer
+int to_int(string_view text, int fallback) {
+	int value = fallback;
+	from_chars(text.data(), text.data() + text.size(), value);
+	return value;
+}
+
+void start_timer(GameData& game_data, int seconds, std::chrono::steady_clock::time_point deadline) {
+	game_data.play_duration_seconds = seconds;
+	game_data.play_deadline = deadline;
+	game_data.timer_active = true;
+}
+
+void start_timer(GameData& game_data, int seconds) {
+	start_timer(game_data, seconds, std::chrono::steady_clock::now() + std::chrono::seconds(seconds));
+}
+
+int64_t to_int64(string_view text, int64_t fallback) {
+	int64_t value = fallback;
+	from_chars(text.data(), text.data() + text.size(), value);
+	return value;
+}
+
+/*
+ * "/play N[:ÉCHÉANCE]" et "/choice N[:ÉCHÉANCE]" : l'échéance, dans l'horloge du
+ * serveur, est convertie en heure locale si le décalage est connu ; sinon le
+ * compte à rebours part de la réception et le trajet réseau est perdu pour le joueur.
+ */
+void start_timer(GameData& game_data, const CommandView& cmd, int fallback) {
+	const auto& p = cmd.params;
+	int seconds = p.empty() ? fallback : to_int(p[0], fallback);
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(seconds);
+
+	if (p.size() >= 2 && game_data.clock.synced()) {
+		int64_t server_deadline = to_int64(p[1], -1);
+		if (server_deadline >= 0) {
+			deadline = clamp(game_data.clock.to_local(server_deadline), now, deadline);
+		}
+	}
+
+	start_timer(game_data, seconds, deadline);
+}
+
+void apply_info(GameData& game_data, const CommandView& cmd) {
+	const auto& p = cmd.params;
+	switch (cmd.info) {
+		case InfoType::ID:
+			log_event(game_data, concat("Nom du serveur : ", p[1]));
+			break;
+		case InfoType::LOGIN:
+			log_event(game_data, concat(p[2], " viens de se connecter (", p[1], ")"));
+			game_data.players.find_or_add(p[2]);
+			break;
+		case InfoType::GAME:
+			log_event(game_data, concat("Rounds (", p[1], ") avec ", p[2], " joueurs"));
+			game_data.rounds = p[1];
+			break;
+		case InfoType::WAIT:
+			log_event(game_data, concat("C'est au tour de ", p[1], " de mettre un mot"));
+			game_data.current_player = p[1];
+			if (to_lowercase(p[1]) != to_lowercase(game_data.current_login)) {
+				game_data.game_state = WAITING_TURN;
+			}
+			game_data.players.find_or_add(p[1]);
+			break;
+		case InfoType::SAY: {
+			string_view player = game_data.players.name(p[1]);
+			log_event(game_data, concat(player, " a dit ", p[2]));
+			game_data.players.add_word(player, p[2]);
+			break;
+		}
+		case InfoType::CHOICE:
+			log_event(game_data, concat(game_data.players.name(p[1]), " a voté pour ", game_data.players.name(p[2])));
+			break;
+		case InfoType::ANSWER:
+			log_event(game_data, concat("L'imposteur était ", p[1], ", son mot était '", p[2], "', les autres avaient '", p[3], "'"));
+			game_data.game_state = RESULT;
+
+			game_data.impostor_name = p[1];
+			game_data.impostor_word = p[2];
+			game_data.common_word = p[3];
+			start_timer(game_data, 60);
+			break;
+		case InfoType::RESULT:
+			// Une seule passe sur les paires joueur:score, chaque joueur trouvé en O(1)
+			for (size_t i = 1; i + 1 < p.size(); i += 2) {
+				game_data.players.set_score(game_data.players.name(p[i]), p[i + 1]);
+			}
+			break;
+		case InfoType::TOP:
+			game_data.leaderboard_total = p[1];
+			game_data.leaderboard.clear();
+			for (size_t i = 2; i + 1 < p.size(); i += 2) {
+				game_data.leaderboard.emplace_back(p[i], p[i + 1]);
+			}
+			game_data.leaderboard_version++;
+			break;
+		case InfoType::RANK:
+			if (to_lowercase(p[1]) == to_lowercase(game_data.current_login)) {
+				game_data.my_rank = concat(p[2], "/", p[4]);
+				game_data.leaderboard_version++;
 			} else {
-				screen.Post([&] {
-					lock_guard<mutex> lock(game_data.mtx);
-					game_data.game_log.push_back("Erreur de lecture socket.");
-					running = false;
-				});
-				break;
+				log_event(game_data, concat(p[1], " est ", p[2], "e sur ", p[4], " (", p[3], " points)"));
 			}
-		} else if (n == 0) {
-			// Connexion fermée proprement par le serveur
-			screen.Post([&] {
-				lock_guard<mutex> lock(game_data.mtx);
-				game_data.game_log.push_back("Connexion fermée par le serveur.");
-				running = false;
-			});
 			break;
+		case InfoType::ROSTER:
+			game_data.player_ids = true;
+			game_data.ids_requested = false;
+			for (size_t i = 1; i + 1 < p.size(); i += 2) {
+				game_data.players.set_id(p[i], p[i + 1]);
+			}
+			break;
+		case InfoType::ALERT:
+			log_event(game_data, concat("ALERTE: ", p[1]));
+			game_data.game_state = WAITING;
+			break;
+		case InfoType::UNKNOWN:
+			break;
+	}
+}
+
+void apply_ret(GameData& game_data, string_view verb, string_view code) {
+	if (verb == "LOGIN") {
+		if (code == "000") {
+			log_event(game_data, "Connexion réussie ! Vous êtes connecté en tant que " + game_data.current_login);
+			game_data.game_state = WAITING;
+			game_data.players.find_or_add(game_data.current_login);
+		} else if (code == "101") {
+			log_event(game_data, "Nom d'utilisateur déjà utilisé.");
+			game_data.game_state = WAITING_USERNAME;
+		} else if (code == "107") {
+			log_event(game_data, "Nom d'utilisateur invalide.");
+			game_data.game_state = WAITING_USERNAME;
+		} else if (code == "202") {
+			log_event(game_data, "Commande non attendue.");
 		}
+	} else if (verb == "PLAY") {
+		if (code == "000") {
+			game_data.game_state = WAITING_TURN;
+		} else if (code == "102") {
+			log_event(game_data, "Ce n'est pas votre tour.");
+			game_data.game_state = WAITING_TURN;
+		} else if (code == "103") {
+			log_event(game_data, "Mot déjà utilisé.");
+			game_data.game_state = PLAYING;
+		} else if (code == "108") {
+			log_event(game_data, "Mot invalide (contient ':').");
+			game_data.game_state = PLAYING;
+		} else if (code == "202") {
+			log_event(game_data, "Commande non attendue.");
+		}
+	} else if (verb == "CHOICE") {
+		if (code == "000") {
+			game_data.game_state = VOTING;
+		} else if (code == "105") {
+			log_event(game_data, "Vous ne pouvez pas voter pour vous-même.");
+			game_data.game_state = VOTING;
+		} else if (code == "106") {
+			log_event(game_data, "Joueur inconnu.");
+			game_data.game_state = VOTING;
+		} else if (code == "202") {
+			log_event(game_data, "Commande non attendue.");
+		}
+	} else if (verb == "RANK" && code == "106") {
+		log_event(game_data, "Joueur absent du classement.");
+	} else if (verb == "PROTO" && code == "201") {
+		if (game_data.ids_requested) {
+			game_data.ids_requested = false; // Serveur sans identifiants : on garde les noms
+		} else {
+			log_event(game_data, "Commande inconnue.");
+		}
+	}
+}
 
-		recv_buffer.append(buffer, n);
-		size_t pos = 0;
+// Applique une commande du serveur à l'état du jeu (appelé sous game_data.mtx)
+void apply_command(GameData& game_data, const CommandView& cmd) {
+	const auto& p = cmd.params;
+	switch (cmd.type) {
+		case MSG_LOGIN:
+			log_event(game_data, "Veuillez vous connecter.");
+			game_data.game_state = WAITING_USERNAME;
+			break;
+		case MSG_ASSIGN:
+			log_event(game_data, concat("Votre mot est : ", p.empty() ? "<aucun>" : p[0]));
+			game_data.game_state = ASSIGN;
+			game_data.current_word = p.empty() ? string_view() : p[0];
+			game_data.players.clear_words();
+			break;
+		case MSG_PLAY:
+			log_event(game_data, "C'est à votre tour de jouer !");
+			game_data.game_state = PLAYING;
+			start_timer(game_data, cmd, 30);
+			break;
+		case MSG_CHOICE:
+			log_event(game_data, "Votez pour un imposteur.");
+			game_data.game_state = VOTING;
+			start_timer(game_data, cmd, 60);
+			break;
+		case MSG_INFO:
+			apply_info(game_data, cmd);
+			break;
+		case MSG_RET:
+			if (p.size() >= 2) apply_ret(game_data, p[0], p[1]);
+			break;
+		case MSG_PING:
+		case MSG_PONG:
+			break; // Traités par le thread réseau dès leur réception
+		default:
+			log_event(game_data, concat("Commande inconnue : ", cmd.command));
+			break;
+	}
+}
 
-		while ((pos = recv_buffer.find('\n')) != string::npos) {
-			string line = recv_buffer.substr(0, pos);
-			recv_buffer.erase(0, pos + 1);
+// Messages lus lors d'un réveil : les vues pointent dans data, partagé avec l'interface
+struct CommandBatch {
+	shared_ptr<const string> data;
+	vector<CommandView> commands;
+};
 
-			if (!line.empty() && line.back() == '\r') {
-				line.pop_back();
-			}
-			if (line.empty()) continue;
-
-			screen.Post([line, &game_data] {
-				lock_guard<mutex> lock(game_data.mtx);
-				auto cmd = parse_input(line);
-				if (!cmd) return;
-
-				if (cmd->command == "/login") {
-					game_data.game_log.push_back("Veuillez vous connecter.");
-					game_data.game_state = WAITING_USERNAME;
-				} else if (cmd->command == "/assign") {
-					game_data.game_log.push_back("Votre mot est : " + (cmd->params.empty() ? "<aucun>" : cmd->params[0]));
-					game_data.game_state = ASSIGN;
-					game_data.current_word = cmd->params[0];
-
-					for (auto& player : game_data.players) {
-						std::get<1>(player).clear();
-					}
-				} else if (cmd->command == "/play") {
-					game_data.game_log.push_back("C'est à votre tour de jouer !");
-					game_data.game_state = PLAYING;
-
-					game_data.play_duration_seconds = stoi(cmd->params[0]);
-					game_data.play_start_time = std::chrono::steady_clock::now();
-					game_data.timer_active = true;
-				} else if (cmd->command == "/choice") {
-					game_data.game_log.push_back("Votez pour un imposteur.");
-					game_data.game_state = VOTING;
-
-					game_data.play_duration_seconds = stoi(cmd->params[0]);
-					game_data.play_start_time = std::chrono::steady_clock::now();
-					game_data.timer_active = true;
-				} else if (cmd->command == "/info") {
-					if (cmd->params.size() >= 2 && cmd->params[0] == "ID") {
-						game_data.game_log.push_back("Nom du serveur : " + cmd->params[1]);
-					} else if (cmd->params[0] == "LOGIN") {
-						game_data.game_log.push_back(cmd->params[2] + " viens de se connecter (" + cmd->params[1] + ")");
-						bool player_exists = false;
-						for (auto& player : game_data.players) {
-							if (std::get<0>(player) == cmd->params[2]) {
-								player_exists = true;
-								break;
-							}
-						}
-						if (!player_exists) {
-							game_data.players.emplace_back(cmd->params[2], vector<string>{}, "");
-							game_data.players_count++;
-						}
-					} else if (cmd->params[0] == "GAME") {
-						game_data.game_log.push_back("Rounds (" + cmd->params[1] + ") avec " + cmd->params[2] + " joueurs");
-						game_data.rounds = cmd->params[1];
-					} else if (cmd->params[0] == "WAIT") {
-						game_data.game_log.push_back("C'est au tour de " + cmd->params[1] + " de mettre un mot");
-						game_data.current_player = cmd->params[1];
-						if(to_lowercase(cmd->params[1]) != to_lowercase(game_data.current_login)) {
-							game_data.game_state = WAITING_TURN;
-						}
+// Découpe en une passe un bloc de messages complets ; false si un message est invalide
+bool parse_batch(string data, bool binary, CommandBatch& batch) {
+	batch.data = make_shared<const string>(move(data));
+	batch.commands.clear();
+
+	const char* p = batch.data->data();
+	const char* end = p + batch.data->size();
+	while (p < end) {
+		CommandView cmd;
+		if (binary) {
+			int consumed = decode_frame(p, end - p, cmd);
+			if (consumed <= 0) return false;
+			p += consumed;
+		} else {
+			const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (!newline) newline = end;
+			bool parsed = parse_line(string_view(p, newline - p), cmd);
+			p = newline + (newline < end);
+			if (!parsed) continue;
+		}
+		batch.commands.push_back(move(cmd));
+	}
+	return true;
+}
 
-						bool player_exists = false;
-						for (auto& player : game_data.players) {
-							if (std::get<0>(player) == cmd->params[1]) {
-								player_exists = true;
-								break;
-							}
-						}
-						if (!player_exists) {
-							game_data.players.emplace_back(cmd->params[1], vector<string>{}, "");
-							game_data.players_count++;
-						}
-					} else if (cmd->params[0] == "SAY") {
-						game_data.game_log.push_back(cmd->params[1] + " a dit " + cmd->params[2]);
-
-						bool player_exists = false;
-						for (auto& player : game_data.players) {
-							if (std::get<0>(player) == cmd->params[1]) {
-								player_exists = true;
-								break;
-							}
-						}
-						if (!player_exists) {
-							game_data.players.emplace_back(cmd->params[1], vector<string>{}, "");
-							game_data.players_count++;
-						}
+// Applique d'un coup, sous un seul verrou, tous les messages lus lors d'un réveil
+void post_commands(ScreenInteractive& screen, GameData& game_data, CommandBatch batch) {
+	if (batch.commands.empty()) return;
+	screen.Post([batch = move(batch), &game_data] {
+		lock_guard<mutex> lock(game_data.mtx);
+		for (const auto& cmd : batch.commands) {
+			apply_command(game_data, cmd);
+		}
+		mark_dirty(game_data);
+	});
+}
+
+// Le classement change à la connexion et à chaque fin de partie : on le redemande
+static bool refreshes_leaderboard(const CommandView& cmd) {
+	if (cmd.type == MSG_INFO) return cmd.info == InfoType::RESULT;
+	return cmd.type == MSG_RET && cmd.params.size() >= 2 && cmd.params[0] == "LOGIN" && cmd.params[1] == "000";
+}
 
-						for (auto& player : game_data.players) {
-							if (std::get<0>(player) == cmd->params[1]) {
-								std::get<1>(player).push_back(cmd->params[2]);
-								break;
-							}
+// "/ping T" avec T l'heure locale d'envoi, renvoyée telle quelle dans le /pong
+static void send_ping() {
+	auto now = chrono::steady_clock::now();
+	send_message(Command{"/ping", {to_string(ClockSync::local_ms(now))}});
+}
+
+// "/pong T:HEURE_SERVEUR" : un aller-retour de plus pour l'estimation du décalage,
+// confié à l'interface (le thread réseau ne prend jamais game_data.mtx)
+static void record_pong(ScreenInteractive& screen, GameData& game_data, const CommandView& cmd,
+		chrono::steady_clock::time_point received) {
+	if (cmd.params.size() < 2) return;
+	int64_t sent = to_int64(cmd.params[0], -1);
+	int64_t server = to_int64(cmd.params[1], -1);
+	if (sent < 0 || server < 0) return;
+
+	screen.Post([&game_data, sent, server, local = ClockSync::local_ms(received)] {
+		lock_guard<mutex> lock(game_data.mtx);
+		game_data.clock.add_sample(sent, server, local);
+		mark_dirty(game_data);
+	});
+}
+
+// Journalise un événement depuis le thread réseau
+static void post_log(ScreenInteractive& screen, GameData& game_data, string entry) {
+	screen.Post([entry = move(entry), &game_data] {
+		lock_guard<mutex> lock(game_data.mtx);
+		log_event(game_data, entry);
+		mark_dirty(game_data);
+	});
+}
+
+// Connexion au serveur, partagée par les coroutines du thread réseau
+struct Session {
+	Connection& conn;
+	GameData& game_data;
+	ScreenInteractive& screen;
+	RecvBuffer recv_buffer;
+	bool connected = true;
+	bool ping_sent = false;
+	bool pong_seen = false; // Un serveur qui ne connaît pas /ping n'en reçoit qu'un
+	string pending;         // Messages sortis de outbox, pas encore acceptés par la socket
+	size_t written = 0;
+	uint64_t negotiation = 0; // Numéro de la renégociation en cours (reconnexion)
+};
+
+constexpr auto RECONNECT_BASE_DELAY = chrono::milliseconds(500);
+constexpr auto RECONNECT_MAX_DELAY = chrono::milliseconds(30000);
+
+/*
+ * Reprise après une reconnexion réussie, une fois le protocole renégocié (dans
+ * read_server) : le joueur est reconnecté sous le même nom ; l'interface et le
+ * journal sont conservés. Les messages qui attendaient l'ancienne connexion sont abandonnés.
+ */
+static void resume_session(Session& s, bool binary, string early, const string& leftover) {
+	binary_protocol = binary;
+	s.recv_buffer = RecvBuffer();
+	s.recv_buffer.append(leftover);
+	stream_recorder.record_reset();
+	stream_recorder.record(early, false);
+	stream_recorder.record(leftover, true);
+
+	string stale;
+	while (outbox.pop(stale)) {}
+	s.pending.clear();
+	s.written = 0;
+	s.connected = true;
+
+	send_message(Command{"/proto", {"ID"}});
+
+	// L'état affiché est remis à zéro par l'interface, avant les messages qui suivent (même file)
+	s.screen.Post([&game_data = s.game_data, resumed = s.conn.tls_resumed()] {
+		lock_guard<mutex> lock(game_data.mtx);
+		log_event(game_data, resumed ? "Reconnecté au serveur (session TLS reprise)." : "Reconnecté au serveur.");
+		game_data.clock.reset(); // Le serveur a pu redémarrer avec une autre horloge
+		// La partie en cours est perdue côté serveur : on revient en attente
+		game_data.timer_active = false;
+		game_data.player_ids = false; // Identifiants redemandés : ceux de l'ancienne connexion ne valent plus
+		game_data.ids_requested = true;
+		game_data.players.clear_ids();
+		if (game_data.game_state != WAITING_USERNAME) {
+			send_message(Command{"/login", {game_data.current_login}}); // Part après /proto ID
+		}
+		mark_dirty(game_data);
+	});
+
+	CommandBatch early_commands;
+	parse_batch(move(early), false, early_commands);
+	post_commands(s.screen, s.game_data, move(early_commands));
+
+	s.pong_seen = false;
+	s.ping_sent = true;
+	send_ping();
+}
+
+/*
+ * Messages complets en tête du tampon : copiés d'un bloc, découpés sans autre copie,
+ * puis transmis à l'interface. Les réponses immédiates (/pong, /top et /rank) ne
+ * partent que pour une session (pas en rejeu). Retourne le nombre de messages,
+ * -1 si une trame est invalide.
+ */
+static long dispatch_messages(RecvBuffer& recv_buffer, bool binary, GameData& game_data, ScreenInteractive& screen,
+		Session* session, chrono::steady_clock::time_point received) {
+	string_view unread = recv_buffer.unread();
+	long complete = complete_prefix(unread.data(), unread.size(), binary);
+	if (complete <= 0) return complete;
+
+	CommandBatch batch;
+	if (!parse_batch(string(unread.substr(0, complete)), binary, batch)) return -1;
+	recv_buffer.consume(complete);
+
+	for (const auto& cmd : batch.commands) {
+		if (!session) break;
+		if (cmd.type == MSG_PING) {
+			send_message(Command{"/pong", {string(cmd.params.empty() ? string_view() : cmd.params[0])}});
+		} else if (cmd.type == MSG_PONG) {
+			record_pong(screen, game_data, cmd, received);
+			session->pong_seen = true;
+		} else if (refreshes_leaderboard(cmd)) {
+			send_message(Command{"/top", {}});
+			send_message(Command{"/rank", {}});
+		}
+	}
+
+	long count = static_cast<long>(batch.commands.size());
+	post_commands(screen, game_data, move(batch));
+	return count;
+}
+
+// Borne la renégociation d'une reconnexion : l'attente de la réponse est annulée
+// si cette négociation (numéro `negotiation`) n'est pas terminée à l'échéance
+IoTask negotiation_timeout(Session& s, uint64_t negotiation) {
+	co_await io_loop.sleep_for(NEGOTIATE_TIMEOUT);
+	if (s.negotiation == negotiation) io_loop.cancel(s.conn.fd());
+}
+
+/*
+ * Lecture : attend la socket dans la boucle, lit tout ce qui est disponible à chaque
+ * réveil puis transmet les messages complets à l'interface en un seul Post.
+ * Une connexion perdue est rétablie avec un délai exponentiel plafonné, tiré au
+ * hasard dans sa seconde moitié pour que les clients coupés ensemble ne reviennent
+ * pas ensemble. L'heure de lecture date les /pong : l'interface ne fausse pas la mesure.
+ */
+constexpr size_t RECV_CHUNK = 4096;
+
+IoTask read_server(Session& s) {
+	static mt19937 rng{random_device{}()};
+	string failure;
+	auto received = chrono::steady_clock::now();
+
+	while (true) {
+		if (!failure.empty()) {
+			post_log(s.screen, s.game_data, failure);
+			failure.clear();
+
+			bool want_binary = binary_protocol;
+			s.connected = false;
+			io_loop.cancel(s.conn.fd());
+			s.conn.close();
+
+			auto delay = RECONNECT_BASE_DELAY;
+			for (int attempt = 1; !s.connected; attempt++) {
+				uniform_int_distribution<long> jitter(delay.count() / 2, delay.count());
+				auto wait = chrono::milliseconds(jitter(rng));
+				post_log(s.screen, s.game_data, concat("Nouvelle tentative de connexion dans ",
+					to_string(wait.count()), " ms (essai ", to_string(attempt), ")."));
+				co_await io_loop.sleep_for(wait);
+
+				// Résolution, connexion et handshake TLS sont menés par la boucle (CONNECT_TIMEOUT au plus)
+				bool opened = false, finished = false;
+				s.conn.reopen_async(io_loop, [&](bool ok) {
+					opened = ok;
+					finished = true;
+					io_loop.notify();
+				});
+				while (!finished) {
+					co_await io_loop.notified();
+				}
+				if (!opened) {
+					delay = min(delay * 2, RECONNECT_MAX_DELAY);
+					continue;
+				}
+
+				// La demande et sa réponse passent par la boucle, bornées par NEGOTIATE_TIMEOUT
+				bool binary = false;
+				string early, buffer;
+				if (want_binary) {
+					uint64_t negotiation = ++s.negotiation;
+					negotiation_timeout(s, negotiation);
+
+					binary_protocol = false;
+					string request = encode_text(Command{"/proto", {"BIN"}});
+					size_t sent = 0;
+					while (sent < request.size()) {
+						ssize_t n = s.conn.write(request.data() + sent, request.size() - sent);
+						if (n > 0) {
+							sent += n;
+						} else if (!(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+								|| !co_await io_loop.writable(s.conn.fd())) {
+							break;
 						}
-					} else if (cmd->params[0] == "CHOICE") {
-						game_data.game_log.push_back(cmd->params[1] + " a voté pour " + cmd->params[2]);
-					} else if (cmd->params[0] == "ANSWER") {
-						game_data.game_log.push_back("L'imposteur était " + cmd->params[1] + ", son mot était '" + cmd->params[2] + "', les autres avaient '" + cmd->params[3] + "'");
-						game_data.game_state = RESULT;
-
-						game_data.impostor_name = cmd->params[1];
-						game_data.impostor_word = cmd->params[2];
-						game_data.common_word = cmd->params[3];
-
-						game_data.play_duration_seconds = 60;
-						game_data.play_start_time = std::chrono::steady_clock::now();
-						game_data.timer_active = true;
-					} else if(cmd->params[0] == "RESULT") {
-						for (size_t i = 1; i < cmd->params.size(); i+=2) {
-							for (auto& player : game_data.players) {
-								if (std::get<0>(player) == cmd->params[i]) {
-									std::get<2>(player) = cmd->params[i+1];
-									break;
-								}
-							}
+					}
+
+					bool answered = sent < request.size(); // Demande non envoyée : on reste en texte
+					while (!answered && co_await io_loop.readable(s.conn.fd())) {
+						char chunk[1024];
+						ssize_t n;
+						while ((n = s.conn.read(chunk, sizeof(chunk))) > 0) {
+							buffer.append(chunk, n);
 						}
-					} else if (cmd->params[0] == "ALERT") {
-						game_data.game_log.push_back("ALERTE: " + cmd->params[1]);
-						game_data.game_state = WAITING;
-					} else {}
-				} else if (cmd->command == "/ret") {
-					if (cmd->params[0] == "LOGIN") {
-						if (cmd->params[1] == "000") {
-							game_data.game_log.push_back("Connexion réussie ! Vous êtes connecté en tant que " + game_data.current_login);
-							game_data.game_state = WAITING;
-
-							bool player_exists = false;
-							for (const auto& player : game_data.players) {
-								if (std::get<0>(player) == game_data.current_login) {
-									player_exists = true;
-									break;
-								}
-							}
-							if (!player_exists) {
-								game_data.players.emplace_back(game_data.current_login, vector<string>{}, "");
-								game_data.players_count++;
-							}
-						} else if (cmd->params[1] == "101") {
-							game_data.game_log.push_back("Nom d'utilisateur déjà utilisé.");
-							game_data.game_state = WAITING_USERNAME;
-						} else if (cmd->params[1] == "107") {
-							game_data.game_log.push_back("Nom d'utilisateur invalide.");
-							game_data.game_state = WAITING_USERNAME;
-						} else if (cmd->params[1] == "202") {
-							game_data.game_log.push_back("Commande non attendue.");
-						} else {}
-					} else if (cmd->params[0] == "PLAY") {
-						if (cmd->params[1] == "000") {
-							game_data.game_state = WAITING_TURN;
-						} else if (cmd->params[1] == "102") {
-							game_data.game_log.push_back("Ce n'est pas votre tour.");
-							game_data.game_state = WAITING_TURN;
-						} else if (cmd->params[1] == "103") {
-							game_data.game_log.push_back("Mot déjà utilisé.");
-							game_data.game_state = PLAYING;
-						} else if (cmd->params[1] == "108") {
-							game_data.game_log.push_back("Mot invalide (contient ':').");
-							game_data.game_state = PLAYING;
-						} else if (cmd->params[1] == "202") {
-							game_data.game_log.push_back("Commande non attendue.");
-						} else {}
-					} else if (cmd->params[0] == "CHOICE") {
-						if (cmd->params[1] == "000") {
-							game_data.game_state = VOTING;
-						} else if (cmd->params[1] == "105") {
-							game_data.game_log.push_back("Vous ne pouvez pas voter pour vous-même.");
-							game_data.game_state = VOTING;
-						} else if (cmd->params[1] == "106") {
-							game_data.game_log.push_back("Joueur inconnu.");
-							game_data.game_state = VOTING;
-						} else if (cmd->params[1] == "202") {
-							game_data.game_log.push_back("Commande non attendue.");
-						} else {}
-					} else if (cmd->params[0] == "PROTO" && cmd->params[1] == "201") {
-						game_data.game_log.push_back("Commande inconnue.");
-					} else {}
-				} else {
-					game_data.game_log.push_back("Commande inconnue : " + cmd->command);
+						answered = take_proto_answer(buffer, early, binary)
+							|| !(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+					}
+					s.negotiation++; // Délai désarmé
 				}
-			});
+				resume_session(s, binary, move(early), buffer);
+			}
+			io_loop.notify(); // L'écriture reprend sur la nouvelle connexion
+			received = chrono::steady_clock::now();
+		}
+
+		if (dispatch_messages(s.recv_buffer, binary_protocol, s.game_data, s.screen, &s, received) < 0) {
+			failure = "Trame invalide reçue du serveur.";
+			continue;
+		}
+
+		if (!co_await io_loop.readable(s.conn.fd())) {
+			failure = "Erreur de lecture socket.";
+			continue;
 		}
+
+		// Vidage complet de la socket (et du tampon TLS), lu directement dans recv_buffer
+		while (true) {
+			char* dest = s.recv_buffer.prepare(RECV_CHUNK);
+			ssize_t n = s.conn.read(dest, RECV_CHUNK);
+			if (n > 0) {
+				s.recv_buffer.commit(n);
+				stream_recorder.record(string_view(dest, n), binary_protocol);
+			} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				break;
+			} else {
+				// Les messages déjà reçus sont encore transmis avant la reconnexion
+				failure = n == 0 ? "Connexion fermée par le serveur." : "Erreur de lecture socket.";
+				break;
+			}
+		}
+		received = chrono::steady_clock::now();
+
+		if (!failure.empty()) {
+			dispatch_messages(s.recv_buffer, binary_protocol, s.game_data, s.screen, &s, received);
+		}
+	}
+}
+
+// Écriture : vide outbox dans l'ordre et n'attend la socket que lorsqu'elle est pleine
+IoTask write_server(Session& s) {
+	while (true) {
+		if (!s.connected) {
+			co_await io_loop.notified();
+			continue;
+		}
+		if (s.written == s.pending.size()) {
+			s.pending.clear();
+			s.written = 0;
+			string msg;
+			while (outbox.pop(msg)) {
+				s.pending += msg;
+			}
+			if (s.pending.empty()) {
+				co_await io_loop.notified();
+				continue;
+			}
+		}
+
+		ssize_t n = s.conn.write(s.pending.data() + s.written, s.pending.size() - s.written);
+		if (n > 0) {
+			s.written += n;
+		} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			co_await io_loop.writable(s.conn.fd());
+		} else {
+			// Connexion perdue : la lecture s'en apercevra et reconnectera
+			s.pending.clear();
+			s.written = 0;
+			co_await io_loop.notified();
+		}
+	}
+}
+
+// Mesure de latence : un /ping toutes les PING_INTERVAL tant que le serveur y répond
+IoTask ping_server(Session& s) {
+	while (true) {
+		if (s.connected && (s.pong_seen || !s.ping_sent)) {
+			send_ping();
+			s.ping_sent = true;
+		}
+		co_await io_loop.sleep_for(PING_INTERVAL);
+	}
+}
+
+atomic<uint64_t> frames_rendered{0}; // Images produites par le rendu (bilan du rejeu)
+
+/*
+ * Rejeu d'un enregistrement (-P) à la place de la connexion : les blocs passent par
+ * le même découpage que les lectures de la socket, à leur rythme d'origine ou, en
+ * mode rapide (-F), aussi vite que possible. Le bilan (messages traités et images
+ * rendues par seconde) est journalisé, et la fenêtre se ferme en mode rapide.
+ */
+IoTask replay_stream(StreamReplay& replay, bool fast, GameData& game_data, ScreenInteractive& screen, string& summary) {
+	RecvBuffer recv_buffer;
+	StreamChunk chunk;
+	uint64_t messages = 0, bytes = 0;
+	uint64_t first_frame = frames_rendered;
+	auto start = chrono::steady_clock::now();
+
+	while (replay.next(chunk)) {
+		if (!fast) {
+			co_await io_loop.sleep_until(start + chunk.at);
+		} else if (io_loop.stopping()) {
+			co_return;
+		}
+
+		if (chunk.kind == ChunkKind::RESET) {
+			recv_buffer = RecvBuffer();
+			continue;
+		}
+		recv_buffer.append(chunk.data);
+		bytes += chunk.data.size();
+
+		long count = dispatch_messages(recv_buffer, chunk.kind == ChunkKind::BINARY, game_data, screen, nullptr, {});
+		if (count < 0) {
+			post_log(screen, game_data, "Trame invalide dans l'enregistrement.");
+			co_return;
+		}
+		messages += count;
+	}
+
+	// Posté après tous les lots : s'exécute une fois que l'interface les a tous appliqués
+	screen.Post([&summary, &screen, &game_data, fast, messages, bytes, first_frame, start] {
+		double seconds = max(1e-9, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+		uint64_t frames = frames_rendered - first_frame;
+		summary = concat("Rejeu terminé : ", to_string(messages), " messages (", to_string(bytes), " octets) en ",
+			to_string(seconds), " s, ", to_string(static_cast<uint64_t>(messages / seconds)), " messages/s, ",
+			to_string(frames), " images (", to_string(static_cast<uint64_t>(frames / seconds)), " images/s)");
+
+		lock_guard<mutex> lock(game_data.mtx);
+		log_event(game_data, summary);
+		mark_dirty(game_data);
+		if (fast) screen.Exit();
+	});
+}
+
+constexpr auto SPINNER_PERIOD = chrono::milliseconds(100); // Une image de spinner
+constexpr auto SPLASH_DURATION = chrono::seconds(5);
+constexpr auto SIGNAL_CHECK_PERIOD = chrono::seconds(1);   // Prise en compte de SIGINT au repos
+
+// Spinners affichés (écran d'accueil, attente du tour des autres)
+static bool spinner_visible(const GameData& game_data) {
+	return game_data.show_splash || game_data.game_state == ASSIGN || game_data.game_state == WAITING_TURN;
+}
+
+/*
+ * Planificateur de rafraîchissement : redessine dès que l'état change (generation),
+ * chaque seconde pendant un compte à rebours, et toutes les SPINNER_PERIOD seulement
+ * si un spinner est à l'écran. Sans activité, le thread dort.
+ */
+void schedule_redraws(GameData& game_data, ScreenInteractive& screen, atomic<bool>& running) {
+	unique_lock<mutex> lock(game_data.mtx);
+	uint64_t drawn = game_data.generation;
+
+	while (running) {
+		auto now = chrono::steady_clock::now();
+		auto deadline = now + SIGNAL_CHECK_PERIOD;
+		bool animated = spinner_visible(game_data);
+
+		if (animated) {
+			deadline = min(deadline, now + SPINNER_PERIOD);
+		}
+		if (game_data.show_splash) {
+			deadline = min(deadline, game_data.splash_start_time + SPLASH_DURATION);
+		}
+		if (game_data.timer_active) {
+			// Prochain changement de la seconde affichée
+			auto left = chrono::duration_cast<chrono::milliseconds>(game_data.play_deadline - now);
+			auto tick = left.count() > 0 ? left % chrono::seconds(1) : chrono::milliseconds(0);
+			deadline = min(deadline, now + (tick.count() ? tick : chrono::milliseconds(1000)));
+		}
+
+		bool woken = game_data.generation != drawn ||
+			game_data.changed.wait_until(lock, deadline) == cv_status::no_timeout;
+		if (!running) break;
+
+		now = chrono::steady_clock::now();
+		bool redraw = woken || game_data.timer_active || sigint_received;
+		if (game_data.show_splash && now >= game_data.splash_start_time + SPLASH_DURATION) {
+			game_data.show_splash = false;
+			redraw = true;
+		}
+		if (animated && !woken) {
+			shift++;
+			redraw = true;
+		}
+		if (!redraw) continue;
+
+		drawn = game_data.generation;
+		lock.unlock();
+		screen.PostEvent(Event::Custom);
+		lock.lock();
 	}
 }
 
@@ -391,37 +893,253 @@ string join(const string& separator, const vector<string>& items) {
 	return result;
 }
 
+// Ce que l'affichage lit dans GameData, copié sous le verrou en quelques microsecondes
+struct RenderSnapshot {
+	bool show_splash = false;
+	GAME_STATE game_state = WAITING_USERNAME;
+	string current_login;
+	string current_word;
+	string current_player;
+	string impostor_name;
+	string impostor_word;
+	string common_word;
+	string rounds;
+	int remaining_time = 0;
+	int play_duration_seconds = 1;
+	int64_t rtt = -1; // Latence lissée, -1 tant qu'elle n'est pas mesurée
+
+	// Données des sous-arbres à reconstruire (copiées seulement si leur version a changé)
+	uint64_t players_version = 0;
+	uint64_t log_version = 0;
+	uint64_t leaderboard_version = 0;
+	bool players_changed = false;
+	vector<PlayerInfo> players;
+	vector<string> new_log_entries;
+	bool leaderboard_changed = false;
+	vector<pair<string, string>> leaderboard;
+	string leaderboard_total;
+	string my_rank;
+};
+
+// Sous-arbres coûteux, conservés d'une image à l'autre tant que leur donnée ne change pas
+struct RenderCache {
+	uint64_t players_version = UINT64_MAX;
+	Element players_table;
+	uint64_t log_version = 0;
+	Elements log_rows;     // Uniquement les dernières lignes, celles qui tiennent à l'écran
+	Element game_log;
+	uint64_t leaderboard_version = UINT64_MAX;
+	string leaderboard_login;
+	Element leaderboard;
+	bool leaderboard_empty = true;
+};
+
+// Appelé sous game_data.mtx : uniquement des copies, aucune construction d'Element
+RenderSnapshot take_snapshot(GameData& game_data, const RenderCache& cache, size_t log_rows) {
+	RenderSnapshot snap;
+	snap.show_splash = game_data.show_splash;
+	snap.game_state = game_data.game_state;
+	snap.current_login = game_data.current_login;
+	snap.current_word = game_data.current_word;
+	snap.current_player = game_data.current_player;
+	snap.impostor_name = game_data.impostor_name;
+	snap.impostor_word = game_data.impostor_word;
+	snap.common_word = game_data.common_word;
+	snap.rounds = game_data.rounds;
+	snap.remaining_time = get_remaining_time(game_data);
+	snap.play_duration_seconds = max(1, game_data.play_duration_seconds);
+	snap.rtt = game_data.clock.synced() ? game_data.clock.smoothed_rtt() : -1;
+	snap.players_version = game_data.players.version();
+	snap.log_version = game_data.game_log.total();
+	snap.leaderboard_version = game_data.leaderboard_version;
+
+	if (cache.players_version != snap.players_version) {
+		snap.players_changed = true;
+		snap.players = game_data.players.all();
+	}
+
+	// Seules les entrées ajoutées depuis la dernière image, et visibles, sont copiées
+	uint64_t missing = snap.log_version - cache.log_version;
+	size_t copied = min<uint64_t>(min<uint64_t>(missing, log_rows), game_data.game_log.size());
+	for (size_t i = game_data.game_log.size() - copied; i < game_data.game_log.size(); i++) {
+		snap.new_log_entries.push_back(game_data.game_log.at(i));
+	}
+
+	if (cache.leaderboard_version != game_data.leaderboard_version || cache.leaderboard_login != game_data.current_login) {
+		snap.leaderboard_changed = true;
+		snap.leaderboard = game_data.leaderboard;
+		snap.leaderboard_total = game_data.leaderboard_total;
+		snap.my_rank = game_data.my_rank;
+	}
+	return snap;
+}
+
+Element build_players_table(const vector<PlayerInfo>& players) {
+	Table players_table;
+	vector<vector<string>> players_data;
+	players_data.push_back({ " Joueur", " Mots", " Score   " });
+
+	for (const auto& player : players) {
+		string words = player.words.empty() ? " -" : join(", ", player.words);
+		string score = player.score.empty() ? " 0" : " " + player.score; // Affiche "0" au lieu de vide
+		players_data.push_back({ " " + player.username, words, score });
+	}
+
+	players_table = Table(players_data);
+	players_table.SelectAll().Border(LIGHT);
+	players_table.SelectColumn(0).Border(DOUBLE);
+	players_table.SelectColumn(1).Border(DOUBLE);
+	players_table.SelectColumn(2).Border(DOUBLE);
+	players_table.SelectColumn(0).Decorate(flex);
+	players_table.SelectColumn(1).Decorate(flex);
+	players_table.SelectRow(0).Decorate(bold);
+	players_table.SelectRow(0).SeparatorVertical(LIGHT);
+	players_table.SelectRow(0).Border(DOUBLE);
+	
+	auto content = players_table.SelectRows(1, -1);
+	content.DecorateCellsAlternateRow(color(Color::Blue), 3, 0);
+	content.DecorateCellsAlternateRow(color(Color::Cyan), 3, 1);
+	content.DecorateCellsAlternateRow(color(Color::White), 3, 2);
+
+	return players_table.Render();
+}
+
+Element build_leaderboard(const RenderSnapshot& snap) {
+	Elements leaderboard_entries;
+	for (size_t i = 0; i < snap.leaderboard.size(); i++) {
+		auto entry = hbox({
+			text(" " + to_string(i + 1) + ". " + snap.leaderboard[i].first),
+			filler(),
+			text(snap.leaderboard[i].second + " ") | color(Color::Yellow)
+		});
+		if (to_lowercase(snap.leaderboard[i].first) == to_lowercase(snap.current_login)) {
+			entry = entry | bold;
+		}
+		leaderboard_entries.push_back(entry);
+	}
+	if (!snap.my_rank.empty()) {
+		leaderboard_entries.push_back(separator());
+		leaderboard_entries.push_back(text(" Votre rang : " + snap.my_rank) | color(Color::Green));
+	}
+	return window(text(" Classement (" + snap.leaderboard_total + " joueurs) "), vbox(move(leaderboard_entries)) | yframe);
+}
+
+// Hors verrou : ne reconstruit que les sous-arbres dont la donnée a changé
+void update_render_cache(RenderCache& cache, RenderSnapshot& snap, size_t log_rows) {
+	if (snap.players_changed) {
+		cache.players_table = build_players_table(snap.players);
+		cache.players_version = snap.players_version;
+	}
+
+	if (!snap.new_log_entries.empty() || !cache.game_log) {
+		for (auto& entry : snap.new_log_entries) {
+			cache.log_rows.push_back(text(move(entry)));
+		}
+		if (cache.log_rows.size() > log_rows) {
+			cache.log_rows.erase(cache.log_rows.begin(), cache.log_rows.end() - log_rows);
+		}
+		cache.log_version = snap.log_version;
+
+		// yframe suit l'élément focalisé : la dernière entrée reste visible
+		Elements rows = cache.log_rows;
+		if (!rows.empty()) rows.back() = rows.back() | focus;
+		cache.game_log = window(text(" Evenements "), vbox(move(rows)) | yframe | flex);
+	}
+
+	if (snap.leaderboard_changed) {
+		cache.leaderboard = build_leaderboard(snap);
+		cache.leaderboard_empty = snap.leaderboard.empty();
+		cache.leaderboard_version = snap.leaderboard_version;
+		cache.leaderboard_login = snap.current_login;
+	}
+}
+
 int main(int argc, char* argv[]) {
 	string server_ip = "127.0.0.1";
 	int port = 5000;
+	bool want_binary = false;
+	TlsOptions tls;
+	string log_spill; // Fichier recevant les entrées sorties du journal en mémoire
+	string record_path, replay_path;
+	bool replay_fast = false;
 
 	for (int i = 1; i < argc; i++) {
 		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
 			server_ip = argv[++i];
 		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
 			port = stoi(argv[++i]);
+		} else if (strcmp(argv[i], "-b") == 0) {
+			want_binary = true;
+		} else if (strcmp(argv[i], "-S") == 0) {
+			tls.enabled = true;
+		} else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+			tls.ca_file = argv[++i];
+		} else if (strcmp(argv[i], "-K") == 0) {
+			tls.verify = false;
+		} else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+			log_spill = argv[++i];
+		} else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+			record_path = argv[++i];
+		} else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+			replay_path = argv[++i];
+		} else if (strcmp(argv[i], "-F") == 0) {
+			replay_fast = true;
 		}
 	}
 
-	int sockfd = connect_to_server(server_ip, port);
-	if (sockfd < 0) {
-		cerr << "Error connecting to server" << endl;
+	signal(SIGPIPE, SIG_IGN);
+
+	// Rejeu : aucune connexion, le flux vient de l'enregistrement
+	StreamReplay replay;
+	if (!replay_path.empty() && !replay.open(replay_path)) {
+		cerr << "Impossible de lire l'enregistrement " << replay_path << endl;
 		return 1;
 	}
+	if (!record_path.empty() && !stream_recorder.open(record_path)) {
+		cerr << "Impossible de créer l'enregistrement " << record_path << endl;
+		return 1;
+	}
+
+	Connection conn;
+	string early_lines, leftover;
+	if (replay_path.empty()) {
+		if (!conn.open(server_ip, port, tls)) {
+			cerr << "Error connecting to server" << endl;
+			return 1;
+		}
+
+		if (want_binary) {
+			binary_protocol = negotiate_binary(conn, early_lines, leftover);
+		}
+		stream_recorder.record(early_lines, false);
+		stream_recorder.record(leftover, true);
 
-	int flags = fcntl(sockfd, F_GETFL, 0);
-	fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
+		conn.set_nonblocking();
+	}
 
 	GameData game_data;
 	atomic<bool> running{true};
 
+	if (!log_spill.empty() && !game_data.game_log.open_spill(log_spill)) {
+		cerr << "Impossible d'ouvrir le fichier de journal " << log_spill << endl;
+		return 1;
+	}
+
+	if (!io_loop.valid()) {
+		perror("epoll");
+		return 1;
+	}
+
 	signal(SIGINT, signal_handler);
 
-	thread splash_timer([&] {
-		this_thread::sleep_for(chrono::seconds(5));
-		lock_guard<mutex> lock(game_data.mtx);
-		game_data.show_splash = false;
-	});
+	// Joueurs désignés par identifiant : le serveur répond par /info ROSTER, ou 201 s'il ne les connaît pas
+	if (replay_path.empty()) {
+		game_data.ids_requested = true;
+		send_message(Command{"/proto", {"ID"}});
+	}
+
+	game_data.splash_start_time = chrono::steady_clock::now();
+	game_data.show_splash = replay_path.empty(); // Le rejeu démarre tout de suite
 
 	auto screen = ScreenInteractive::ScreenInteractive::Fullscreen();
 	string login_input;
@@ -430,33 +1148,46 @@ int main(int argc, char* argv[]) {
 
 	auto on_click = [&] {
 		lock_guard<mutex> lock(game_data.mtx);
+
+		// "/top [N]" ou "/rank [nom]" saisis dans n'importe quel champ : consultation du classement
+		for (string* input : {&login_input, &word_input, &choice_input}) {
+			auto cmd = parse_input(*input);
+			if (cmd && (cmd->command == "/top" || cmd->command == "/rank")) {
+				send_message(*cmd);
+				input->clear();
+				return;
+			}
+		}
+
 		if (game_data.game_state == WAITING_USERNAME && !login_input.empty()) {
-			send_message(sockfd, "/login " + login_input);
+			send_message(Command{"/login", {login_input}});
 			game_data.current_login = login_input;
 			login_input.clear();
 		} else if (game_data.game_state == PLAYING && !word_input.empty()) {
-			send_message(sockfd, "/play " + word_input);
-			game_data.game_log.push_back(word_input);
+			send_message(Command{"/play", {word_input}});
+			log_event(game_data, word_input);
 			word_input.clear();
 		} else if (game_data.game_state == VOTING && !choice_input.empty()) {
-			send_message(sockfd, "/choice " + choice_input);
+			// Le nom saisi devient un identifiant si le serveur en attribue (le nom reste accepté)
+			string id = game_data.player_ids ? game_data.players.id_of(choice_input) : "";
+			send_message(Command{"/choice", {id.empty() ? choice_input : id}});
 			choice_input.clear();
 		}
 	};
 
 	auto spinner_tab_renderer = Renderer([&] {
 		Elements entries;
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
-		entries.push_back(spinner(16, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
+		entries.push_back(spinner(16, shift) | bold | size(WIDTH, GREATER_THAN, 2) | border | flex);
 		return hbox({
 			std::move(entries)
 		}) | flex;
@@ -464,7 +1195,7 @@ int main(int argc, char* argv[]) {
 
 		auto spinner_tab_renderer_info = Renderer([&] {
 		Elements entries;
-		entries.push_back(spinner(15, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2));
+		entries.push_back(spinner(15, shift) | bold | size(WIDTH, GREATER_THAN, 2));
 		return hbox({
 			std::move(entries)
 		});
@@ -472,7 +1203,7 @@ int main(int argc, char* argv[]) {
 
 	auto spinner_tab_renderer_splash = Renderer([&] {
 		Elements entries;
-		entries.push_back(spinner(21, shift / 2) | bold | size(WIDTH, GREATER_THAN, 2));
+		entries.push_back(spinner(21, shift) | bold | size(WIDTH, GREATER_THAN, 2));
 		return hbox({
 			std::move(entries)
 		});
@@ -553,86 +1284,70 @@ int main(int argc, char* argv[]) {
 		if (event == Event::CtrlC || sigint_received) {
 			running = false;
 			screen.Exit();
-			if (sockfd != -1) {
-				close(sockfd);
-				sockfd = -1;
-			}
+			game_data.changed.notify_all();
 			return true;
 		}
 		return false;
 	});
 
+	RenderCache render_cache;
 	auto renderer = Renderer(root_container, [&] {
-		lock_guard<mutex> lock(game_data.mtx);
-		
+		frames_rendered++;
+
+		// Le journal n'affiche jamais plus de lignes que le terminal n'en contient
+		size_t log_rows = max(1, Terminal::Size().dimy);
+
+		RenderSnapshot snap;
+		{
+			lock_guard<mutex> lock(game_data.mtx);
+
+			// Vérifier si le temps est écoulé
+			if (game_data.timer_active && get_remaining_time(game_data) <= 0) {
+				game_data.timer_active = false;
+				// Ajouter une action si nécessaire quand le timer expire
+				log_event(game_data, "Temps écoulé !");
+			}
+
+			snap = take_snapshot(game_data, render_cache, log_rows);
+		}
+
 		// Vérifier si le splash screen doit être affiché
-		if (game_data.show_splash) {
+		if (snap.show_splash) {
 			return splash_component->Render();
 		}
 
+		update_render_cache(render_cache, snap, log_rows);
+
 		// Calculer le temps restant et la progression
-		int remaining_time = get_remaining_time(game_data);
-		float progress = 1.0f - (static_cast<float>(remaining_time) / game_data.play_duration_seconds);
-		
-		// Vérifier si le temps est écoulé
-		if (game_data.timer_active && remaining_time <= 0) {
-			game_data.timer_active = false;
-			// Ajouter une action si nécessaire quand le timer expire
-			game_data.game_log.push_back("Temps écoulé !");
-		}
-
-		Elements log_entries;
-		for (const auto& entry : game_data.game_log) {
-			log_entries.push_back(text(entry));
-		}
-
-		Table players_table;
-		vector<vector<string>> players_data;
-		players_data.push_back({ " Joueur", " Mots", " Score   " });
-
-		for (const auto& player : game_data.players) {
-			string words = std::get<1>(player).empty() ? " -" : join(", ", std::get<1>(player));
-			string score = std::get<2>(player).empty() ? " 0" : " " + std::get<2>(player); // Affiche "0" au lieu de vide
-			players_data.push_back({ " " + std::get<0>(player), words, score });
-		}
-
-		players_table = Table(players_data);
-		players_table.SelectAll().Border(LIGHT);
-		players_table.SelectColumn(0).Border(DOUBLE);
-		players_table.SelectColumn(1).Border(DOUBLE);
-		players_table.SelectColumn(2).Border(DOUBLE);
-		players_table.SelectColumn(0).Decorate(flex);
-		players_table.SelectColumn(1).Decorate(flex);
-		players_table.SelectRow(0).Decorate(bold);
-		players_table.SelectRow(0).SeparatorVertical(LIGHT);
-		players_table.SelectRow(0).Border(DOUBLE);
-		
-		auto content = players_table.SelectRows(1, -1);
-		content.DecorateCellsAlternateRow(color(Color::Blue), 3, 0);
-		content.DecorateCellsAlternateRow(color(Color::Cyan), 3, 1);
-		content.DecorateCellsAlternateRow(color(Color::White), 3, 2);
+		int remaining_time = snap.remaining_time;
+		float progress = 1.0f - (static_cast<float>(remaining_time) / snap.play_duration_seconds);
 
 		auto info_panel = vbox({
 			window(text(" Informations du jeu "), 
 			hbox({
-				text(" Moi : " + game_data.current_login) | bgcolor(Color(Color::Black)),
-				text(" | Rounds : " + game_data.rounds ) | bgcolor(Color(Color::Black)),
-				text(" | Votre mot secret : " + game_data.current_word) | bgcolor(Color(Color::Black)),
-				text(" | C'est au tour de : " + game_data.current_player + " ") | bgcolor(Color(Color::Black)),
-				game_data.game_state == RESULT ? text(" | L'imposteur était " + game_data.impostor_name + "son mot était " + game_data.impostor_word + ". Les autres avaient le mot " + game_data.common_word) | bgcolor(Color(Color::Black)) : text(""),
+				text(" Moi : " + snap.current_login) | bgcolor(Color(Color::Black)),
+				text(" | Rounds : " + snap.rounds ) | bgcolor(Color(Color::Black)),
+				text(" | Votre mot secret : " + snap.current_word) | bgcolor(Color(Color::Black)),
+				text(" | C'est au tour de : " + snap.current_player + " ") | bgcolor(Color(Color::Black)),
+				snap.rtt >= 0 ? text(" | Ping : " + to_string(snap.rtt) + " ms ") | bgcolor(Color(Color::Black)) : text(""),
+				snap.game_state == RESULT ? text(" | L'imposteur était " + snap.impostor_name + "son mot était " + snap.impostor_word + ". Les autres avaient le mot " + snap.common_word) | bgcolor(Color(Color::Black)) : text(""),
 				filler(),
 				spinner_tab_renderer_info->Render()
 			}))
 		}) | bgcolor(LinearGradient().Angle(45).Stop(0x1a2a6c_rgb).Stop(0xb21f1f_rgb).Stop(0xfdbb2d_rgb));
 
-		auto players_panel = window(text(" Joueurs "), players_table.Render() | flex);
-		auto game_log_panel = window(text(" Evenements "), vbox(log_entries) | yframe | flex);
-		auto top_panel = hbox({players_panel | flex/* game_log_panel | flex */}) | flex | bgcolor(LinearGradient().Angle(45).Stop(0x141E30_rgb).Stop(0x243B55_rgb));
+
+		auto players_panel = window(text(" Joueurs "), render_cache.players_table | flex);
+		auto top_panel = hbox({
+			players_panel | flex,
+			render_cache.leaderboard_empty ? text("") : render_cache.leaderboard | size(WIDTH, EQUAL, 32)
+			/* render_cache.game_log | flex */
+		}) | flex | bgcolor(LinearGradient().Angle(45).Stop(0x141E30_rgb).Stop(0x243B55_rgb));
 
 		Component input_component;
 		string input_title;
 
-		switch(game_data.game_state) {
+		switch(snap.game_state) {
 			case WAITING_USERNAME:
 				input_title = " Connexion ";
 				input_component = login_component;
@@ -651,8 +1366,8 @@ int main(int argc, char* argv[]) {
 				break;
 			case RESULT:
 				input_title = " Résultats ";
-				input_component = Renderer([&] { 
-					return text("L'imposteur était " + game_data.impostor_name + ", son mot était " + game_data.impostor_word + ". Les autres avaient le mot " + game_data.common_word) | blink; 
+				input_component = Renderer([result = "L'imposteur était " + snap.impostor_name + ", son mot était " + snap.impostor_word + ". Les autres avaient le mot " + snap.common_word] {
+					return text(result) | blink;
 				});
 				break;
 			default:
@@ -669,11 +1384,11 @@ int main(int argc, char* argv[]) {
 		return vbox({
 			info_panel,
 			top_panel,
-			game_data.game_state == PLAYING || game_data.game_state == VOTING ? hbox({
+			snap.game_state == PLAYING || snap.game_state == VOTING ? hbox({
 				text(" Temps restant "+ to_string(remaining_time) + "s : "),
 				gauge(progress) | color(Color::Cyan) |flex
 			}) : text(""),
-			game_data.game_state == RESULT ? hbox({
+			snap.game_state == RESULT ? hbox({
 				text(" Prochaine partie dans "+ to_string(remaining_time) + "s : "),
 				gauge(progress) | color(Color::Cyan) | flex
 			}) : text(""),
@@ -690,33 +1405,47 @@ int main(int argc, char* argv[]) {
 		});
 	});
 
-	auto screenRedraw = std::thread([&](){
-		while(running && !sigint_received){
-			screen.PostEvent(ftxui::Event::Custom);
-			screen.Post([&] { shift++; });
-			std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Prevent High CPU Usage.
-		}
+	thread redraw_thread(schedule_redraws, ref(game_data), ref(screen), ref(running));
+
+	CommandBatch early_commands;
+	parse_batch(move(early_lines), false, early_commands);
+	post_commands(screen, game_data, move(early_commands));
+
+	// Tout le réseau (ou le rejeu) vit dans un seul thread, celui de la boucle
+	string replay_summary;
+	Session session{conn, game_data, screen};
+	session.recv_buffer.append(leftover);
+	thread io_thread([&] {
+		io_loop.run([&] {
+			if (replay_path.empty()) {
+				read_server(session);
+				write_server(session);
+				ping_server(session);
+			} else {
+				replay_stream(replay, replay_fast, game_data, screen, replay_summary);
+			}
+		});
 	});
-
-	thread server_thread(handle_server_messages, sockfd, ref(game_data), ref(screen), ref(running));
 	screen.Loop(renderer);
 	
 	running = false;
 	sigint_received = true;
 
-	if (sockfd != -1) {
-		close(sockfd);
+	io_loop.stop();
+	if (io_thread.joinable()) {
+		io_thread.join();
 	}
-
-	if (server_thread.joinable()) {
-		server_thread.join();
-	}
-	if (screenRedraw.joinable()) {
-		screenRedraw.join();
+	conn.close();
+	{
+		lock_guard<mutex> lock(game_data.mtx);
+		game_data.changed.notify_all();
 	}
-	if (splash_timer.joinable()) {
-		splash_timer.join();
+	if (redraw_thread.joinable()) {
+		redraw_thread.join();
 	}
 
+	if (!replay_summary.empty()) {
+		cout << replay_summary << endl;
+	}
 	return 0;
 }
\ No newline at end of file
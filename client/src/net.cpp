@@ -0,0 +1,406 @@
+#include "net.hpp"
+#include "io_loop.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+using namespace std;
+
+// Résultat d'un getaddrinfo lancé dans son propre thread ; sa fin est signalée par
+// event_fd, que la coroutine de connexion attend dans la boucle. Libéré par le dernier des deux.
+struct Resolution {
+	mutex mtx;
+	int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	int error = EAI_AGAIN;
+	struct addrinfo* result = nullptr;
+
+	~Resolution() {
+		if (result) freeaddrinfo(result);
+		if (event_fd >= 0) ::close(event_fd);
+	}
+};
+
+static void start_resolution(const shared_ptr<Resolution>& resolution, const string& host, int port) {
+	thread([resolution, host, service = to_string(port)] {
+		struct addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_ADDRCONFIG;
+
+		struct addrinfo* result = nullptr;
+		int error = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+		{
+			lock_guard<mutex> lock(resolution->mtx);
+			resolution->error = error;
+			resolution->result = result;
+		}
+		uint64_t one = 1;
+		if (write(resolution->event_fd, &one, sizeof(one)) < 0) {
+			// Personne n'attend plus : la connexion a été abandonnée
+		}
+	}).detach();
+}
+
+// Alterne les familles d'adresses en gardant l'ordre de préférence de getaddrinfo (RFC 8305)
+static vector<const struct addrinfo*> interleave_families(const struct addrinfo* list) {
+	vector<const struct addrinfo*> first, other;
+	for (const struct addrinfo* ai = list; ai; ai = ai->ai_next) {
+		(ai->ai_family == list->ai_family ? first : other).push_back(ai);
+	}
+
+	vector<const struct addrinfo*> ordered;
+	for (size_t i = 0; i < first.size() || i < other.size(); i++) {
+		if (i < first.size()) ordered.push_back(first[i]);
+		if (i < other.size()) ordered.push_back(other[i]);
+	}
+	return ordered;
+}
+
+/*
+ * Résolution puis course des tentatives, dans une seule coroutine qui n'attend qu'un
+ * descripteur : le WaitSet réunit la fin de getaddrinfo, les sockets en cours de
+ * connexion et l'échéance (prochaine tentative ou abandon).
+ */
+static IoTask connect_task(IoLoop& loop, string host, int port, chrono::steady_clock::time_point deadline,
+		function<void(int)> on_done) {
+	WaitSet waits;
+	auto resolution = make_shared<Resolution>();
+	if (!waits.valid() || resolution->event_fd < 0) {
+		on_done(-1);
+		co_return;
+	}
+
+	start_resolution(resolution, host, port);
+	waits.watch(resolution->event_fd, EPOLLIN);
+	waits.arm(deadline);
+
+	bool resolved = false, expired = false;
+	while (!resolved && !expired && co_await loop.readable(waits.fd())) {
+		resolved = !waits.collect(expired).empty();
+	}
+	waits.unwatch(resolution->event_fd);
+
+	struct addrinfo* list = nullptr;
+	if (resolved) {
+		lock_guard<mutex> lock(resolution->mtx);
+		if (resolution->error == 0) list = resolution->result;
+	}
+	if (!list) {
+		on_done(-1);
+		co_return;
+	}
+	vector<const struct addrinfo*> candidates = interleave_families(list);
+
+	// Une nouvelle tentative démarre toutes les CONNECTION_ATTEMPT_DELAY, ou aussitôt
+	// qu'une tentative échoue, sans abandonner les précédentes ; la première connectée gagne.
+	vector<int> pending;
+	size_t next = 0;
+	int winner = -1;
+	auto next_attempt = chrono::steady_clock::now();
+
+	while (winner < 0) {
+		auto now = chrono::steady_clock::now();
+		if (now >= deadline) break;
+
+		if (next < candidates.size() && (now >= next_attempt || pending.empty())) {
+			const struct addrinfo* ai = candidates[next++];
+			int fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if (fd < 0) continue;
+			if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+				winner = fd;
+			} else if (errno == EINPROGRESS) {
+				pending.push_back(fd);
+				waits.watch(fd, EPOLLOUT);
+				next_attempt = now + CONNECTION_ATTEMPT_DELAY;
+			} else {
+				::close(fd); // Refus immédiat : la suivante part tout de suite
+			}
+			continue;
+		}
+		if (pending.empty()) break; // Toutes les adresses ont échoué
+
+		waits.arm(next < candidates.size() ? min(deadline, next_attempt) : deadline);
+		if (!co_await loop.readable(waits.fd())) break;
+
+		for (const auto& ready : waits.collect(expired)) {
+			int error = 0;
+			socklen_t len = sizeof(error);
+			getsockopt(ready.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+			waits.unwatch(ready.fd);
+			pending.erase(find(pending.begin(), pending.end(), ready.fd));
+
+			if (error == 0 && winner < 0) {
+				winner = ready.fd;
+			} else {
+				::close(ready.fd);
+				next_attempt = chrono::steady_clock::now(); // Échec rapide (RST, injoignable) : pas d'attente
+			}
+		}
+	}
+
+	for (int fd : pending) {
+		::close(fd);
+	}
+	on_done(winner);
+}
+
+void connect_async(IoLoop& loop, const string& host, int port, chrono::steady_clock::time_point deadline,
+		function<void(int)> on_done) {
+	connect_task(loop, host, port, deadline, move(on_done));
+}
+
+// Dernière session TLS reçue (ticket), réutilisée à la reconnexion vers le même serveur
+static string cached_peer;
+static SSL_SESSION* cached_session = nullptr;
+
+static int on_new_session(SSL*, SSL_SESSION* session) {
+	if (cached_session) SSL_SESSION_free(cached_session);
+	cached_session = session;
+	return 1; // On garde la référence
+}
+
+static SSL_CTX* client_context(const TlsOptions& tls) {
+	static SSL_CTX* ctx = nullptr;
+	if (ctx) return ctx;
+
+	ctx = SSL_CTX_new(TLS_client_method());
+	if (!ctx) return nullptr;
+
+	SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+	SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ctx, on_new_session);
+
+	if (tls.verify) {
+		SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+		if (tls.ca_file.empty()) {
+			SSL_CTX_set_default_verify_paths(ctx);
+		} else {
+			SSL_CTX_load_verify_locations(ctx, tls.ca_file.c_str(), nullptr);
+		}
+	} else {
+		SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+	}
+
+	return ctx;
+}
+
+Connection::~Connection() {
+	close();
+}
+
+// Session TLS sur une socket connectée, avec reprise de la dernière session vers ce serveur
+static SSL* new_session(int sockfd, const string& host, int port, const TlsOptions& tls) {
+	SSL_CTX* ctx = client_context(tls);
+	SSL* ssl = ctx ? SSL_new(ctx) : nullptr;
+	if (!ssl) return nullptr;
+	if (SSL_set_fd(ssl, sockfd) != 1) {
+		SSL_free(ssl);
+		return nullptr;
+	}
+
+	SSL_set_tlsext_host_name(ssl, host.c_str());
+	if (tls.verify) SSL_set1_host(ssl, host.c_str());
+
+	string peer = host + ":" + to_string(port);
+	if (cached_session && cached_peer == peer) {
+		SSL_set_session(ssl, cached_session);
+	}
+	cached_peer = peer;
+	return ssl;
+}
+
+// Handshake TLS sur la socket non bloquante : SSL_connect est relancé à chaque
+// WANT_READ/WANT_WRITE, l'attente passant par la boucle, jusqu'à deadline au plus
+static IoTask tls_handshake(IoLoop& loop, SSL* ssl, int fd, chrono::steady_clock::time_point deadline,
+		function<void(bool)> on_done) {
+	WaitSet waits;
+	if (!waits.valid()) {
+		on_done(false);
+		co_return;
+	}
+	waits.arm(deadline);
+
+	while (true) {
+		int ret = SSL_connect(ssl);
+		if (ret == 1) {
+			on_done(true);
+			co_return;
+		}
+
+		int error = SSL_get_error(ssl, ret);
+		if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) break;
+		waits.watch(fd, error == SSL_ERROR_WANT_READ ? EPOLLIN : EPOLLOUT);
+
+		bool expired = false;
+		if (!co_await loop.readable(waits.fd())) break;
+		waits.collect(expired);
+		if (expired) break;
+	}
+	on_done(false);
+}
+
+// Connexion et handshake TLS éventuel dans la boucle, en CONNECT_TIMEOUT au plus
+void Connection::open_async(IoLoop& loop, const string& host, int port, const TlsOptions& tls, function<void(bool)> on_done) {
+	close();
+	host_ = host;
+	port_ = port;
+	tls_ = tls;
+	resumed_ = false;
+
+	auto deadline = chrono::steady_clock::now() + CONNECT_TIMEOUT;
+	connect_async(loop, host, port, deadline, [this, &loop, deadline, on_done = move(on_done)](int sockfd) {
+		if (sockfd < 0) {
+			on_done(false);
+			return;
+		}
+		if (!tls_.enabled) {
+			fd_ = sockfd;
+			on_done(true);
+			return;
+		}
+
+		SSL* ssl = new_session(sockfd, host_, port_, tls_);
+		if (!ssl) {
+			::close(sockfd);
+			on_done(false);
+			return;
+		}
+		tls_handshake(loop, ssl, sockfd, deadline, [this, ssl, sockfd, on_done](bool ok) {
+			if (!ok) {
+				ERR_print_errors_fp(stderr);
+				SSL_free(ssl);
+				::close(sockfd);
+				on_done(false);
+				return;
+			}
+			resumed_ = SSL_session_reused(ssl);
+			ssl_ = ssl;
+			fd_ = sockfd;
+			on_done(true);
+		});
+	});
+}
+
+void Connection::reopen_async(IoLoop& loop, function<void(bool)> on_done) {
+	open_async(loop, host_, port_, tls_, move(on_done));
+}
+
+// Au démarrage, la boucle du client ne tourne pas encore : open_async sur une boucle privée.
+// La socket est rendue bloquante pour la négociation qui suit.
+bool Connection::open(const string& host, int port, const TlsOptions& tls) {
+	IoLoop loop;
+	if (!loop.valid()) return false;
+
+	bool opened = false;
+	loop.run([&] {
+		open_async(loop, host, port, tls, [&](bool ok) {
+			opened = ok;
+			loop.stop();
+		});
+	});
+	if (!opened) return false;
+
+	int flags = fcntl(fd_, F_GETFL, 0);
+	fcntl(fd_, F_SETFL, flags & ~O_NONBLOCK);
+	return true;
+}
+
+void Connection::set_nonblocking() {
+	int flags = fcntl(fd_, F_GETFL, 0);
+	fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Comme read(2) : -1 avec errno == EAGAIN s'il n'y a rien à lire pour l'instant
+ssize_t Connection::read(void* buf, size_t len) {
+	if (fd_ < 0) {
+		errno = EBADF;
+		return -1;
+	}
+	if (!ssl_) return ::read(fd_, buf, len);
+
+	int ret = SSL_read(ssl_, buf, static_cast<int>(len));
+	if (ret > 0) return ret;
+
+	switch (SSL_get_error(ssl_, ret)) {
+		case SSL_ERROR_WANT_READ:
+		case SSL_ERROR_WANT_WRITE:
+			errno = EAGAIN;
+			return -1;
+		case SSL_ERROR_ZERO_RETURN:
+			return 0;
+		default:
+			ERR_clear_error();
+			errno = EIO;
+			return -1;
+	}
+}
+
+// Comme write(2) : -1 avec errno == EAGAIN si la socket (ou la session TLS) n'accepte rien pour l'instant
+ssize_t Connection::write(const void* buf, size_t len) {
+	if (fd_ < 0) {
+		errno = EBADF;
+		return -1;
+	}
+	if (!ssl_) return ::write(fd_, buf, len);
+
+	int ret = SSL_write(ssl_, buf, static_cast<int>(len));
+	if (ret > 0) return ret;
+
+	switch (SSL_get_error(ssl_, ret)) {
+		case SSL_ERROR_WANT_READ:
+		case SSL_ERROR_WANT_WRITE:
+			errno = EAGAIN;
+			return -1;
+		default:
+			ERR_clear_error();
+			errno = EIO;
+			return -1;
+	}
+}
+
+// Écriture complète, pour la négociation qui précède le passage en non bloquant
+bool Connection::write_all(const void* buf, size_t len) {
+	const char* data = static_cast<const char*>(buf);
+	while (len > 0) {
+		ssize_t n = write(data, len);
+		if (n > 0) {
+			data += n;
+			len -= n;
+		} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			struct pollfd pfd = {fd_, POLLOUT, 0};
+			poll(&pfd, 1, 100);
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Connection::close() {
+	if (ssl_) {
+		SSL_shutdown(ssl_);
+		SSL_free(ssl_);
+		ssl_ = nullptr;
+	}
+	if (fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef NET_HPP
+#define NET_HPP
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+
+typedef struct ssl_st SSL;
+class IoLoop;
+
+struct TlsOptions {
+	bool enabled = false;
+	bool verify = true;   // Vérification du certificat et du nom d'hôte
+	std::string ca_file;  // Autorité de certification (sinon magasin système)
+};
+
+constexpr std::chrono::seconds CONNECT_TIMEOUT{5};               // Résolution, connexion et handshake TLS
+constexpr std::chrono::milliseconds CONNECTION_ATTEMPT_DELAY{250}; // Happy eyeballs (RFC 8305)
+
+// Connexion au serveur, en clair ou en TLS. Après la négociation, seul le thread
+// réseau (cf. io_loop.hpp) y lit et y écrit : une session OpenSSL n'est pas réentrante.
+struct Connection {
+	~Connection();
+
+	bool open(const std::string& host, int port, const TlsOptions& tls); // Bloquant, avant le démarrage de la boucle
+	// Dans la boucle : on_done(succès) est appelé dans son thread, la socket restant non bloquante
+	void open_async(IoLoop& loop, const std::string& host, int port, const TlsOptions& tls, std::function<void(bool)> on_done);
+	void reopen_async(IoLoop& loop, std::function<void(bool)> on_done); // Même serveur (reprise de session TLS)
+	ssize_t read(void* buf, size_t len);
+	ssize_t write(const void* buf, size_t len);
+	bool write_all(const void* buf, size_t len);
+	void set_nonblocking();
+	void close();
+
+	int fd() const { return fd_; }
+	bool tls_resumed() const { return resumed_; }
+
+private:
+	int fd_ = -1;
+	SSL* ssl_ = nullptr;
+	bool resumed_ = false;
+	std::string host_;
+	int port_ = 0;
+	TlsOptions tls_;
+};
+
+/*
+ * Connexion menée dans la boucle : getaddrinfo (IPv4/IPv6) dans un thread dont la fin
+ * est signalée à la boucle, puis tentatives en parallèle (happy eyeballs). on_done est
+ * appelé dans le thread de la boucle avec la socket connectée (non bloquante) ou -1.
+ */
+void connect_async(IoLoop& loop, const std::string& host, int port, std::chrono::steady_clock::time_point deadline,
+	std::function<void(int)> on_done);
+
+
+#endif
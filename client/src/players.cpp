@@ -0,0 +1,72 @@
+#include "players.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+using namespace std;
+
+constexpr size_t MAX_PLAYER_ID = 65536; // Garde-fou : un identifiant aberrant n'agrandit pas la table
+
+// La clé n'est construite qu'à l'ajout d'un joueur : les recherches ne copient rien
+PlayerInfo& PlayerList::find_or_add(string_view username) {
+	if (PlayerInfo* player = find(username)) return *player;
+
+	index_.emplace(string(username), players_.size());
+	players_.push_back(PlayerInfo{string(username), {}, ""});
+	version_++;
+	return players_.back();
+}
+
+PlayerInfo* PlayerList::find(string_view username) {
+	auto it = index_.find(username);
+	return it == index_.end() ? nullptr : &players_[it->second];
+}
+
+void PlayerList::add_word(string_view username, string_view word) {
+	find_or_add(username).words.emplace_back(word);
+	version_++;
+}
+
+void PlayerList::set_score(string_view username, string_view score) {
+	PlayerInfo* player = find(username);
+	if (!player || player->score == score) return;
+	player->score = score;
+	version_++;
+}
+
+void PlayerList::clear_words() {
+	for (auto& player : players_) {
+		player.words.clear();
+	}
+	version_++;
+}
+
+void PlayerList::set_id(string_view id, string_view username) {
+	size_t index = 0;
+	auto [end, ec] = from_chars(id.data(), id.data() + id.size(), index);
+	if (ec != errc() || end != id.data() + id.size() || index >= MAX_PLAYER_ID) return;
+	if (index >= names_by_id_.size()) names_by_id_.resize(index + 1);
+	names_by_id_[index] = username;
+	find_or_add(username);
+}
+
+string_view PlayerList::name(string_view id) const {
+	size_t index = 0;
+	auto [end, ec] = from_chars(id.data(), id.data() + id.size(), index);
+	if (ec != errc() || end != id.data() + id.size() || index >= names_by_id_.size() || names_by_id_[index].empty()) return id;
+	return names_by_id_[index];
+}
+
+bool looks_like_id(string_view text) {
+	if (!text.empty() && (text[0] == '-' || text[0] == '+')) text.remove_prefix(1);
+	if (text.empty()) return false;
+	return all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+string PlayerList::id_of(string_view username) const {
+	if (looks_like_id(username)) return string(username);
+	for (size_t i = 0; i < names_by_id_.size(); i++) {
+		if (names_by_id_[i] == username) return to_string(i);
+	}
+	return "";
+}
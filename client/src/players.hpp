@@ -0,0 +1,53 @@
+#ifndef PLAYERS_HPP
+#define PLAYERS_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct PlayerInfo {
+	std::string username;
+	std::vector<std::string> words; // Mots joués pendant la partie en cours
+	std::string score;              // Tel que reçu dans /info RESULT ("3+2"), vide avant la première partie
+};
+
+// Forme réservée aux identifiants (des chiffres, éventuellement précédés d'un signe), refusée comme nom par le serveur
+bool looks_like_id(std::string_view text);
+
+// Joueurs de la table, dans l'ordre d'arrivée, avec accès direct par nom.
+// version() change à chaque modification (invalidation du rendu).
+class PlayerList {
+public:
+	PlayerInfo& find_or_add(std::string_view username);
+	PlayerInfo* find(std::string_view username);
+	void add_word(std::string_view username, std::string_view word);
+	void set_score(std::string_view username, std::string_view score);
+	void clear_words();
+
+	// Identifiants négociés (/proto ID) : SAY, CHOICE et RESULT désignent les joueurs par
+	// l'identifiant que /info ROSTER associe à leur nom
+	void set_id(std::string_view id, std::string_view username);
+	std::string_view name(std::string_view id) const; // L'identifiant tel quel s'il est inconnu
+	std::string id_of(std::string_view username) const; // Vide si inconnu, tel quel si c'est déjà un identifiant
+	void clear_ids() { names_by_id_.clear(); }
+
+	const std::vector<PlayerInfo>& all() const { return players_; }
+	size_t size() const { return players_.size(); }
+	uint64_t version() const { return version_; }
+
+private:
+	std::vector<PlayerInfo> players_;
+	// Hachage transparent : find() prend le string_view tel quel, sans construire de std::string
+	struct NameHash {
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+	};
+	std::unordered_map<std::string, size_t, NameHash, std::equal_to<>> index_; // Nom -> position dans players_
+	std::vector<std::string> names_by_id_;          // Identifiants denses : accès direct
+	uint64_t version_ = 0;
+};
+
+#endif
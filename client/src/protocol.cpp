@@ -0,0 +1,227 @@
+#include "protocol.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <cstring>
+
+using namespace std;
+
+static const char* const msg_names[] = {
+	"/unknown", "/login", "/play", "/choice", "/assign", "/info", "/ret", "/proto", "/top", "/rank",
+	"/ping", "/pong"
+};
+static constexpr size_t msg_type_count = sizeof(msg_names) / sizeof(msg_names[0]);
+
+static MsgType msg_type_from_name(const string& name) {
+	for (size_t t = 1; t < msg_type_count; t++) {
+		if (name == msg_names[t]) return static_cast<MsgType>(t);
+	}
+	return MSG_UNKNOWN;
+}
+
+unique_ptr<Command> parse_input(const string& input) {
+	if (input.empty() || input[0] != '/') return nullptr;
+
+	auto cmd = make_unique<Command>();
+	size_t space_pos = input.find(' ');
+	if (space_pos == string::npos) {
+		cmd->command = input;
+		return cmd;
+	}
+
+	cmd->command = input.substr(0, space_pos);
+	string rest = input.substr(space_pos + 1);
+	stringstream ss(rest);
+	string segment;
+
+	while (getline(ss, segment, ':')) {
+		segment.erase(segment.begin(), find_if(segment.begin(), segment.end(), [](unsigned char ch) {
+			return !isspace(ch);
+		}));
+		segment.erase(find_if(segment.rbegin(), segment.rend(), [](unsigned char ch) {
+			return !isspace(ch);
+		}).base(), segment.end());
+
+		if (!segment.empty()) {
+			cmd->params.push_back(segment);
+		}
+	}
+
+	return cmd;
+}
+
+string encode_text(const Command& cmd) {
+	string line = cmd.command;
+	for (size_t i = 0; i < cmd.params.size(); i++) {
+		line += (i == 0 ? " " : ":") + cmd.params[i];
+	}
+	return line + "\n";
+}
+
+static void varint_encode(uint64_t value, string& out) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+// Retourne le nombre d'octets lus, 0 si incomplet, -1 si invalide
+static int varint_decode(const char* data, size_t len, uint64_t& value) {
+	uint64_t result = 0;
+	for (size_t i = 0; i < len && i < 10; i++) {
+		uint8_t byte = static_cast<uint8_t>(data[i]);
+		result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+		if (!(byte & 0x80)) {
+			value = result;
+			return static_cast<int>(i) + 1;
+		}
+	}
+	return len >= 10 ? -1 : 0;
+}
+
+string encode_binary(const Command& cmd) {
+	string payload;
+	payload.push_back(static_cast<char>(msg_type_from_name(cmd.command)));
+	varint_encode(cmd.params.size(), payload);
+	for (const auto& param : cmd.params) {
+		varint_encode(param.size(), payload);
+		payload += param;
+	}
+
+	string frame;
+	varint_encode(payload.size(), frame);
+	return frame + payload;
+}
+
+// Sous-type d'un /info et nombre minimal de champs (sous-type compris) pour l'exploiter
+static InfoType info_type(string_view name, size_t param_count) {
+	struct Entry { string_view name; InfoType type; size_t min_params; };
+	static constexpr Entry entries[] = {
+		{"ID", InfoType::ID, 2}, {"LOGIN", InfoType::LOGIN, 3}, {"GAME", InfoType::GAME, 3},
+		{"WAIT", InfoType::WAIT, 2}, {"SAY", InfoType::SAY, 3}, {"CHOICE", InfoType::CHOICE, 3},
+		{"ANSWER", InfoType::ANSWER, 4}, {"RESULT", InfoType::RESULT, 1}, {"TOP", InfoType::TOP, 2},
+		{"RANK", InfoType::RANK, 5}, {"ALERT", InfoType::ALERT, 2}, {"ROSTER", InfoType::ROSTER, 1},
+	};
+	for (const auto& entry : entries) {
+		if (entry.name == name) return param_count >= entry.min_params ? entry.type : InfoType::UNKNOWN;
+	}
+	return InfoType::UNKNOWN;
+}
+
+static void classify(CommandView& out) {
+	out.type = MSG_UNKNOWN;
+	for (size_t t = 1; t < msg_type_count; t++) {
+		if (out.command == msg_names[t]) {
+			out.type = static_cast<MsgType>(t);
+			break;
+		}
+	}
+	out.info = out.type == MSG_INFO && !out.params.empty() ? info_type(out.params[0], out.params.size()) : InfoType::UNKNOWN;
+}
+
+static bool is_space(char c) {
+	return isspace(static_cast<unsigned char>(c));
+}
+
+bool parse_line(string_view line, CommandView& out) {
+	if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+	if (line.empty() || line[0] != '/') return false;
+
+	out.params.clear();
+	size_t space_pos = line.find(' ');
+	out.command = line.substr(0, space_pos);
+
+	if (space_pos != string_view::npos) {
+		// Champs séparés par ':', espaces de bord ignorés, champs vides omis
+		const char* p = line.data() + space_pos + 1;
+		const char* end = line.data() + line.size();
+		while (true) {
+			const char* sep = static_cast<const char*>(memchr(p, ':', end - p));
+			const char* b = p;
+			const char* e = sep ? sep : end;
+			while (b < e && is_space(*b)) b++;
+			while (e > b && is_space(e[-1])) e--;
+			if (b < e) out.params.emplace_back(b, e - b);
+			if (!sep) break;
+			p = sep + 1;
+		}
+	}
+
+	classify(out);
+	return true;
+}
+
+int decode_frame(const char* data, size_t len, CommandView& out) {
+	uint64_t payload_len, field_count;
+	int n = varint_decode(data, len, payload_len);
+	if (n <= 0) return n;
+	if (payload_len == 0 || payload_len > PROTO_MAX_FRAME) return -1;
+	if (len - n < payload_len) return 0;
+
+	const char* p = data + n;
+	const char* end = p + payload_len;
+	uint8_t type = static_cast<uint8_t>(*p++);
+
+	int m = varint_decode(p, end - p, field_count);
+	if (m <= 0) return -1;
+	p += m;
+
+	out.command = msg_names[type < msg_type_count ? type : MSG_UNKNOWN];
+	out.params.clear();
+	for (uint64_t i = 0; i < field_count; i++) {
+		uint64_t field_len;
+		m = varint_decode(p, end - p, field_len);
+		if (m <= 0 || field_len > static_cast<uint64_t>(end - p - m)) return -1;
+		p += m;
+		out.params.emplace_back(p, field_len);
+		p += field_len;
+	}
+
+	classify(out);
+	return n + static_cast<int>(payload_len);
+}
+
+long complete_prefix(const char* data, size_t len, bool binary) {
+	if (!binary) {
+		const void* last = memrchr(data, '\n', len);
+		return last ? static_cast<const char*>(last) - data + 1 : 0;
+	}
+
+	// Saut de trame en trame d'après le préfixe de taille
+	size_t pos = 0;
+	while (pos < len) {
+		uint64_t payload_len;
+		int n = varint_decode(data + pos, len - pos, payload_len);
+		if (n < 0 || (n > 0 && (payload_len == 0 || payload_len > PROTO_MAX_FRAME))) return -1;
+		if (n == 0 || len - pos - n < payload_len) break;
+		pos += n + payload_len;
+	}
+	return static_cast<long>(pos);
+}
+
+char* RecvBuffer::prepare(size_t len) {
+	if (begin_ > 0 && begin_ >= data_.size() / 2) {
+		// Récupère l'espace déjà lu (une copie amortie, pas une par message)
+		memmove(data_.data(), data_.data() + begin_, end_ - begin_);
+		end_ -= begin_;
+		begin_ = 0;
+	}
+	if (data_.size() < end_ + len) data_.resize(end_ + len);
+	return data_.data() + end_;
+}
+
+void RecvBuffer::commit(size_t len) {
+	end_ += len;
+}
+
+void RecvBuffer::append(string_view data) {
+	memcpy(prepare(data.size()), data.data(), data.size());
+	commit(data.size());
+}
+
+void RecvBuffer::consume(size_t len) {
+	begin_ += min(len, end_ - begin_);
+	if (begin_ == end_) begin_ = end_ = 0;
+}
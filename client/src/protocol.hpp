@@ -0,0 +1,83 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Taille maximale d'une trame binaire (hors préfixe), identique au serveur
+constexpr size_t PROTO_MAX_FRAME = 4096;
+
+// Identifiants de type des trames binaires (cf. server/include/protocol.h)
+enum MsgType : uint8_t {
+	MSG_UNKNOWN = 0,
+	MSG_LOGIN   = 1,
+	MSG_PLAY    = 2,
+	MSG_CHOICE  = 3,
+	MSG_ASSIGN  = 4,
+	MSG_INFO    = 5,
+	MSG_RET     = 6,
+	MSG_PROTO   = 7,
+	MSG_TOP     = 8,
+	MSG_RANK    = 9,
+	MSG_PING    = 10,
+	MSG_PONG    = 11,
+};
+
+struct Command {
+	std::string command;
+	std::vector<std::string> params;
+};
+
+std::unique_ptr<Command> parse_input(const std::string& input);
+
+// Encodage texte : "/cmd p1:p2\n"
+std::string encode_text(const Command& cmd);
+
+// Encodage binaire : varint(taille) | u8 type | varint(nb_champs) | { varint(taille) | octets }*
+std::string encode_binary(const Command& cmd);
+
+// Sous-types de /info connus du client
+enum class InfoType : uint8_t {
+	UNKNOWN, ID, LOGIN, GAME, WAIT, SAY, CHOICE, ANSWER, RESULT, TOP, RANK, ALERT, ROSTER
+};
+
+// Message reçu, sans copie : command et params pointent dans le tampon d'origine
+struct CommandView {
+	MsgType type = MSG_UNKNOWN;
+	InfoType info = InfoType::UNKNOWN; // Sous-type d'un /info, UNKNOWN s'il est inconnu ou incomplet
+	std::string_view command;
+	std::vector<std::string_view> params;
+};
+
+// Analyse en une passe d'une ligne texte (sans '\n'), mêmes règles que parse_input()
+bool parse_line(std::string_view line, CommandView& out);
+
+// Retourne le nombre d'octets consommés, 0 si la trame est incomplète, -1 si elle est invalide
+int decode_frame(const char* data, size_t len, CommandView& out);
+
+// Taille des messages complets en tête de data (lignes ou trames), -1 si une trame est invalide
+long complete_prefix(const char* data, size_t len, bool binary);
+
+// Tampon de réception avec curseur de lecture : consommer un message ne déplace rien,
+// l'espace lu n'est récupéré que lorsqu'il représente la moitié du tampon
+class RecvBuffer {
+public:
+	char* prepare(size_t len);   // Zone où lire au plus len octets (read/SSL_read direct)
+	void commit(size_t len);     // Valide les octets écrits dans la zone
+	void append(std::string_view data);
+	void consume(size_t len);
+
+	std::string_view unread() const { return {data_.data() + begin_, end_ - begin_}; }
+	bool empty() const { return begin_ == end_; }
+
+private:
+	std::vector<char> data_;
+	size_t begin_ = 0;
+	size_t end_ = 0;
+};
+
+#endif
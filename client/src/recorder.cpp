@@ -0,0 +1,77 @@
+#include "recorder.hpp"
+
+#include <cinttypes>
+
+using namespace std;
+
+static const char REC_HEADER[] = "IMPOSTEUR-REC 1\n";
+
+StreamRecorder::~StreamRecorder() {
+	if (file_) fclose(file_);
+}
+
+bool StreamRecorder::open(const string& path) {
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) return false;
+	if (file_) fclose(file_);
+	file_ = file;
+	start_ = chrono::steady_clock::now();
+	fputs(REC_HEADER, file_);
+	return true;
+}
+
+void StreamRecorder::record(string_view data, bool binary) {
+	// Les octets reçus avant le démarrage (négociation) peuvent dépasser un bloc
+	do {
+		string_view part = data.substr(0, MAX_RECORD_CHUNK);
+		write(binary ? ChunkKind::BINARY : ChunkKind::TEXT, part);
+		data.remove_prefix(part.size());
+	} while (!data.empty());
+}
+
+void StreamRecorder::record_reset() {
+	write(ChunkKind::RESET, {});
+}
+
+void StreamRecorder::write(ChunkKind kind, string_view data) {
+	if (!file_ || (data.empty() && kind != ChunkKind::RESET)) return;
+
+	auto at = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start_).count();
+	fprintf(file_, "%" PRId64 " %c %zu\n", static_cast<int64_t>(at), static_cast<char>(kind), data.size());
+	fwrite(data.data(), 1, data.size(), file_);
+	// Bufferisé par stdio : un enregistrement coupé net perd au plus les dernières lectures
+}
+
+StreamReplay::~StreamReplay() {
+	if (file_) fclose(file_);
+}
+
+bool StreamReplay::open(const string& path) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) return false;
+
+	char header[sizeof(REC_HEADER)] = {0};
+	if (!fgets(header, sizeof(header), file) || string_view(header) != REC_HEADER) {
+		fclose(file);
+		return false;
+	}
+	if (file_) fclose(file_);
+	file_ = file;
+	return true;
+}
+
+bool StreamReplay::next(StreamChunk& chunk) {
+	if (!file_) return false;
+
+	int64_t at;
+	char kind;
+	size_t size;
+	if (fscanf(file_, "%" SCNd64 " %c %zu", &at, &kind, &size) != 3 || fgetc(file_) != '\n') return false;
+	if (kind != 'T' && kind != 'B' && kind != 'R') return false;
+	if (size > MAX_RECORD_CHUNK) return false; // Fichier corrompu : pas d'allocation démesurée
+
+	chunk.at = chrono::milliseconds(at);
+	chunk.kind = static_cast<ChunkKind>(kind);
+	chunk.data.resize(size);
+	return fread(chunk.data.data(), 1, size, file_) == size;
+}
@@ -0,0 +1,62 @@
+#ifndef RECORDER_HPP
+#define RECORDER_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/*
+ * Enregistrement du flux brut reçu du serveur, pour rejouer une partie sans réseau.
+ * Format : une ligne "IMPOSTEUR-REC 1", puis pour chaque lecture une ligne
+ * "<ms depuis le début> <T|B|R> <taille>" suivie des octets reçus.
+ *   T : octets en protocole texte, B : en protocole binaire,
+ *   R : reconnexion (le tampon de réception repart de zéro, taille 0)
+ */
+// Taille maximale d'un bloc : au-delà, l'écriture est découpée et la lecture refusée
+constexpr size_t MAX_RECORD_CHUNK = 64 * 1024;
+
+enum class ChunkKind : char { TEXT = 'T', BINARY = 'B', RESET = 'R' };
+
+struct StreamChunk {
+	std::chrono::milliseconds at{0};
+	ChunkKind kind = ChunkKind::TEXT;
+	std::string data;
+};
+
+class StreamRecorder {
+public:
+	StreamRecorder() = default;
+	~StreamRecorder();
+
+	StreamRecorder(const StreamRecorder&) = delete;
+	StreamRecorder& operator=(const StreamRecorder&) = delete;
+
+	bool open(const std::string& path);
+	bool is_open() const { return file_ != nullptr; }
+	void record(std::string_view data, bool binary);
+	void record_reset();
+
+private:
+	void write(ChunkKind kind, std::string_view data);
+
+	FILE* file_ = nullptr;
+	std::chrono::steady_clock::time_point start_;
+};
+
+class StreamReplay {
+public:
+	StreamReplay() = default;
+	~StreamReplay();
+
+	StreamReplay(const StreamReplay&) = delete;
+	StreamReplay& operator=(const StreamReplay&) = delete;
+
+	bool open(const std::string& path);
+	bool next(StreamChunk& chunk); // false à la fin du fichier, sur un bloc tronqué ou trop grand
+
+private:
+	FILE* file_ = nullptr;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Tampon d'octets extensible (entrées réseau, trames encodées, ...)
+typedef struct Buffer {
+	char *data;
+	size_t len;
+	size_t cap;
+} Buffer;
+
+bool buffer_reserve(Buffer *buf, size_t extra);
+bool buffer_append(Buffer *buf, const void *data, size_t len);
+void buffer_consume(Buffer *buf, size_t len);
+void buffer_free(Buffer *buf);
+
+#endif
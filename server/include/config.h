@@ -3,16 +3,22 @@
 
 #define DEFAULT_PORT 5000         // Port par défaut
 #define DEFAULT_MAX_PLAYERS 10    // Nombre de joueurs maximum par défaut
+#define MAX_ROOM_PLAYERS 128      // -j au plus : /info RESULT (~30 octets par joueur) doit tenir dans une trame binaire (PROTO_MAX_FRAME)
 #define DEFAULT_MAX_ROUNDS 3      // Nombre de rounds maximum par défaut
 #define DEFAULT_TIMING_PLAY 30    // Durée maximale pour mettre un mot (en secondes) par défaut
 #define DEFAULT_TIMING_CHOICE 60  // Durée maximale de la phase de vote (en secondes) par défaut
+#define DEFAULT_VOTE_GRACE 0      // Délai pour changer d'avis une fois tous les votes reçus (en secondes) par défaut
 #define BUFFER_SIZE 256           // Longueur maximale du buffer
-#define MAX_PLAYERS 10            // Nombre maximal de joueurs par défaut
 #define MAX_USERNAME 16           // Longueur maximale d'un nom d'utilisateur
 #define MIN_USERNAME 3            // Longueur minimale d'un nom d'utilisateur
 #define MAX_WORD 32               // Longueur maximale d'un mot
 #define MIN_PLAYERS 3             // Nombre minimum de joueurs
 #define MAX_ADDR 64               // Longueur maximale d'une addresse
 #define TIMING_BETWEEN_GAMES 60   // Durée d'attente entre les parties
+#define LOGIN_TIMEOUT 30          // Délai pour s'identifier (/login) après l'ouverture de la connexion (en secondes)
+#define IDLE_TIMEOUT 600          // Un joueur en partie (ou qui envoie des /ping) qui n'envoie plus aucune commande est déconnecté (en secondes)
+#define DEFAULT_MAX_PER_IP 4      // Connexions simultanées par adresse IP par défaut (0 : sans limite, boucle locale exemptée)
+#define DEFER_ACCEPT_SECONDS 5    // TCP_DEFER_ACCEPT : le client qui parle le premier a 5 s pour envoyer ses premiers octets
+#define RETRY_AFTER_SECONDS 30    // Délai conseillé aux clients refusés (Retry-After du 503 WebSocket)
 
 #endif
\ No newline at end of file
@@ -3,8 +3,10 @@
 
 #include <stdbool.h>
 #include <time.h>
+#include <stdint.h>
 
 #include "config.h"
+#include "pool.h"
 
 typedef struct Player Player;
 
@@ -15,20 +17,39 @@ typedef struct Played_Word {
 	struct Played_Word *next;
 } Played_Word;
 
+/*
+ * Tampons du dépouillement, alloués une fois pour toutes à la taille de la salle
+ * (max_players) : rien n'est borné à la compilation. Les votes désignent un
+ * identifiant de joueur, chacun est compté directement dans counts[id].
+ */
+typedef struct Vote_Tally {
+	int capacity;              // Joueurs au plus (max_players)
+	int *counts;               // Voix reçues, par identifiant de joueur
+	int *old_scores;           // Par position dans la liste des joueurs
+	int *gains;
+	const char **usernames;
+} Vote_Tally;
+
 typedef struct Game_State {
 	int max_players;
 	int max_rounds;
 	int timing_play;
 	int timing_choice;
+	bool simultaneous;         // Mode simultané : chaque round, tous les joueurs jouent leur mot en même temps
+	int vote_grace;            // Délai pour changer d'avis une fois tous les votes reçus (en secondes, 0 : aucun)
 	enum game_phase phase;
 	int player_count;
 	int impostor_idx;
 	int current_turn;
 	int current_round;
 	int votes_received;
-	time_t phase_start_time;
+	bool votes_complete;       // Tous les joueurs de la partie ont voté : l'échéance du vote a été avancée
+	uint64_t phase_deadline;   // Fin de la phase en cours (clock_ms)
 	int temps_restant;
 	Played_Word *played_words; // Liste des mots joués
+	Arena arena;               // Données de la partie en cours (mots joués), rendues d'un bloc par reset_game
+	Vote_Tally tally;
+	Player **roster;           // Joueurs identifiés, par identifiant (max_players cases, NULL : libre)
 	char impostor_word[MAX_WORD];
 	char common_word[MAX_WORD];
 } Game_State;
@@ -37,8 +58,25 @@ void assign_words(Player *head, Game_State *game);
 bool is_word_played(Game_State *game, const char *word);
 void add_played_word(Game_State *game, const char *word);
 void free_played_words(Game_State *game);
+void start_phase_timer(Game_State *game, int seconds);
+int phase_remaining(const Game_State *game);
+void broadcast_game_info(Player *head, Game_State *game);
+void announce_turn(Player *head, Game_State *game, Player *turn_player);
+void announce_round(Player *head, Game_State *game);
+void reveal_round(Player *head, Game_State *game);
+bool round_complete(Player *head, Game_State *game);
+void start_voting(Player *head, Game_State *game);
 void handle_word_submission(Player *head, Game_State *game, Player *sender, const char *word);
 void handle_vote(Player *head, Game_State *game, Player *voter, const char *vote);
+void check_votes_complete(Player *head, Game_State *game);
 void reset_game(Game_State *game, Player *head);
+bool tally_init(Vote_Tally *tally, int capacity);
+int tally_index(Vote_Tally *tally, Player *head);
+void tally_free(Vote_Tally *tally);
+int roster_add(Game_State *game, Player *player);
+void roster_remove(Player *head, Game_State *game, Player *player);
+Player *roster_get(const Game_State *game, int id);
+bool looks_like_id(const char *text);
+Player *find_player(Player *head, const Game_State *game, const Player *sender, const char *name_or_id);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#define PING_INTERVAL_MS 5000   // Période des /ping envoyés aux clients qui les comprennent
+#define RTT_MAX_SAMPLE_MS 60000 // Au-delà, la réponse est considérée comme invalide
+
+/*
+ * Horloge du serveur : millisecondes d'une horloge monotone. Les échéances envoyées
+ * aux clients (/play N:ÉCHÉANCE, /choice N:ÉCHÉANCE) sont exprimées dans cette
+ * horloge ; chaque client estime son décalage avec elle grâce à /ping et /pong.
+ */
+uint64_t clock_ms(void);
+
+// Mesures d'aller-retour d'un client (lissage façon TCP, RFC 6298)
+typedef struct Rtt_Stats {
+	uint32_t last;
+	uint32_t srtt;    // Moyenne lissée
+	uint32_t rttvar;  // Variation lissée
+	uint32_t min;
+	uint32_t max;
+	uint32_t samples;
+} Rtt_Stats;
+
+void rtt_add_sample(Rtt_Stats *stats, uint32_t rtt);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stddef.h>
+
+#include "config.h"
+
+#define LEADERBOARD_MAX_LEVEL 16    // Niveaux de la skip list (p = 1/4 : plusieurs milliards d'entrées)
+#define LEADERBOARD_DEFAULT_TOP 10  // Taille par défaut de /top
+#define LEADERBOARD_MAX_TOP 50      // Taille maximale de /top (une trame binaire doit tenir dans PROTO_MAX_FRAME)
+
+typedef struct Leaderboard_Row {
+	const char *username;
+	int score;
+} Leaderboard_Row;
+
+/*
+ * Classement global, entièrement en mémoire : skip list indexable (chaque lien
+ * connaît le nombre d'entrées qu'il enjambe) triée par score décroissant puis par
+ * nom. Mise à jour, rang et début du top en O(log n), sans jamais trier.
+ * Reconstruit au démarrage depuis l'instantané de scores.log (cf. store.h).
+ */
+void leaderboard_update(const char *username, int score);
+size_t leaderboard_rank(const char *username, int *score); // 1 pour le premier, 0 si inconnu
+size_t leaderboard_top(Leaderboard_Row *rows, size_t n);
+size_t leaderboard_size(void);
+void leaderboard_free(void);
+
+#endif
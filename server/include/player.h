@@ -2,31 +2,88 @@
 #define PLAYER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "buffer.h"
 #include "config.h"
+#include "latency.h"
+#include "ratelimit.h"
+#include "pool.h"
 
 typedef struct Game_State Game_State;
+typedef struct ssl_st SSL;
+
+enum transport { TRANSPORT_TCP, TRANSPORT_WS };
+
+typedef struct Send_Stats {
+	unsigned long messages;  // Messages mis en file (player_send)
+	unsigned long writes;    // Appels à send() de la boucle poll()
+} Send_Stats;
 
 typedef struct Player Player;
 typedef struct Player {
 	int fd;
 	char addr[MAX_ADDR];
+	uint32_t ip;             // Adresse IPv4 (ordre réseau), pour la limite de connexions par IP
 	char username[MAX_USERNAME];
 	bool username_set;
 	char secret_word[MAX_WORD];
-	char **submitted_words;
-	char vote[MAX_USERNAME];
+	char (*submitted_words)[MAX_WORD]; // Un mot par round, rangés à la suite du joueur dans son objet de pool
+	int id;                  // Identifiant court attribué au /login (indice dans game->roster), -1 avant
+	int vote;                // Identifiant du joueur désigné, -1 sans vote (ou s'il est parti depuis)
+	bool voted;
 	int score;
 	bool ready;
+	bool binary;             // Protocole binaire négocié (/proto BIN)
+	bool ids;                // Identifiants négociés (/proto ID) : SAY, CHOICE et RESULT désignent les joueurs par leur id
+	Buffer in;               // Octets reçus pas encore traités
+	Buffer out;              // Octets en attente d'envoi (socket non bloquante)
+	enum transport transport;
+	bool ws_open;            // Handshake WebSocket terminé
+	Buffer raw;              // Trames WebSocket pas encore décodées
+	SSL *ssl;                // Session TLS (NULL en clair)
+	bool tls_ready;          // Handshake TLS terminé
+	bool tls_want_write;     // OpenSSL attend que la socket soit inscriptible
+	bool pings;              // Le client a envoyé un /ping : il sait aussi répondre aux nôtres
+	uint64_t last_ping;      // Envoi du dernier /ping (clock_ms)
+	uint64_t connected_at;   // Ouverture de la connexion (clock_ms), pour le délai de /login
+	uint64_t last_activity;  // Dernière commande complète reçue, ou début de la partie (clock_ms)
+	Rate_State rate;         // Seaux de jetons (connexion et verbes) contre les rafales de commandes
+	Rtt_Stats rtt;           // Allers-retours mesurés par /ping et /pong
+	Buffer sending;          // io_uring : octets en cours d'envoi (le noyau les lit)
+	int uring_ops;           // io_uring : opérations en vol sur la socket
+	bool uring_dirty;        // io_uring : envoi à soumettre au prochain tour
+	bool uring_closing;      // io_uring : retiré de la liste, libéré à la dernière complétion
+	bool flush_pending;      // Messages retenus par le bouchon, envoyés par player_uncork()
 	Player *next;
 } Player;
 
 Player* add_player(Player **head, int fd, Game_State *game);
 void remove_player(Player **head, int fd, Game_State *game);
+void unlink_player(Player **head, Player *player);
+void free_player(Player *player);
+void free_all_players(Player **head);
+const Slab_Pool *player_pool_stats(void);
 Player* get_player_by_fd(Player *head, int fd);
 Player* get_player_by_index(Player *head, int index);
 Player* get_player_by_username(Player *head, const char *username);
 int count_players(Player *head);
+int count_players_from(Player *head, uint32_t ip);
 int count_ready_players(Player *head);
 bool all_players_ready(Player *head, int ready_count);
+ssize_t player_recv(Player *player, void *buf, size_t len);
+void player_write(Player *player, const void *data, size_t len);
+void player_send(Player *player, const void *data, size_t len);
+void player_flush(Player *player);
+
+/*
+ * Regroupement des envois : pendant le traitement d'un tour de boucle, les messages
+ * de chaque joueur s'accumulent dans sa file de sortie et partent en un seul send()
+ * à player_uncork(), au lieu d'un appel système (et d'un paquet) par message.
+ */
+void player_cork(void);
+void player_uncork(Player *head);
+const Send_Stats *player_send_stats(void);
 
 #endif
\ No newline at end of file
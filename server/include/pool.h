@@ -0,0 +1,51 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+#define SLAB_OBJECTS 32       // Objets par bloc d'un pool
+#define ARENA_CHUNK_SIZE 4096 // Taille minimale d'un bloc d'arène
+
+/*
+ * Pool d'objets de taille fixe : les objets sont découpés dans des blocs de
+ * SLAB_OBJECTS et recyclés par une liste libre, sans repasser par malloc. Les
+ * blocs ne sont rendus qu'à pool_destroy().
+ */
+typedef struct Slab Slab;
+
+typedef struct Slab_Pool {
+	const char *name;
+	size_t object_size;   // Arrondie à l'alignement maximal
+	Slab *slabs;
+	void *free_list;
+	size_t slab_count;
+	size_t in_use;
+	size_t peak;
+	unsigned long allocs; // Depuis le démarrage
+} Slab_Pool;
+
+void pool_init(Slab_Pool *pool, const char *name, size_t object_size);
+void *pool_alloc(Slab_Pool *pool);
+void pool_free(Slab_Pool *pool, void *object);
+void pool_destroy(Slab_Pool *pool);
+
+/*
+ * Arène à pointeur croissant : allocations sans libération individuelle, tout est
+ * rendu d'un coup par arena_reset() (fin de partie). Les blocs sont alors fondus en
+ * un seul, assez grand pour la partie suivante : en régime établi, plus de malloc.
+ */
+typedef struct Arena_Chunk Arena_Chunk;
+
+typedef struct Arena {
+	Arena_Chunk *chunks;
+	size_t used;          // Octets alloués depuis la dernière remise à zéro
+	size_t peak;
+	size_t capacity;
+	unsigned long resets;
+} Arena;
+
+void *arena_alloc(Arena *arena, size_t size);
+void arena_reset(Arena *arena);
+void arena_free(Arena *arena);
+
+#endif
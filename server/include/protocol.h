@@ -0,0 +1,70 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "buffer.h"
+#include "utils.h"
+
+#define PROTO_MAX_FRAME 4096   // Taille maximale d'une trame binaire (hors préfixe)
+#define PROTO_MAX_LINE 1024    // Taille maximale d'une ligne texte
+
+/*
+ * Deux encodages coexistent sur la même connexion :
+ *  - texte : "/info SAY:alice:chat\n", champs séparés par ':'
+ *  - binaire (négocié par "/proto BIN") :
+ *      varint(taille) | u8 type | varint(nb_champs) | { varint(taille) | octets }*
+ * Le binaire n'a aucune restriction sur le contenu des champs.
+ *
+ * Indépendamment, "/proto ID" fait désigner les joueurs par un identifiant court
+ * (attribué au /login) : "/info ROSTER:id:nom:..." donne la correspondance, puis
+ * SAY, CHOICE et RESULT portent l'identifiant ; /choice l'accepte, le nom aussi.
+ */
+enum msg_type {
+	MSG_UNKNOWN = 0,
+	MSG_LOGIN   = 1,
+	MSG_PLAY    = 2,
+	MSG_CHOICE  = 3,
+	MSG_ASSIGN  = 4,
+	MSG_INFO    = 5,
+	MSG_RET     = 6,
+	MSG_PROTO   = 7,
+	MSG_TOP     = 8,
+	MSG_RANK    = 9,
+	MSG_PING    = 10,
+	MSG_PONG    = 11,
+	MSG_TYPE_COUNT
+};
+
+// Message sortant : les champs sont stockés à la suite, chacun terminé par '\0'
+typedef struct Message {
+	enum msg_type type;
+	int field_count;
+	Buffer fields;
+} Message;
+
+void msg_init(Message *msg, enum msg_type type);
+void msg_add(Message *msg, const char *field);
+void msg_addf(Message *msg, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void msg_addi(Message *msg, int value);
+void msg_free(Message *msg);
+
+const char *msg_type_name(enum msg_type type);
+enum msg_type msg_type_from_name(const char *name);
+
+void msg_encode_text(const Message *msg, Buffer *out);
+void msg_encode_binary(const Message *msg, Buffer *out);
+
+size_t varint_encode(uint64_t value, uint8_t *out);
+int varint_decode(const uint8_t *buf, size_t len, uint64_t *value);
+int proto_decode_frame(const uint8_t *buf, size_t len, Command **out);
+
+void send_msg(Player *player, const Message *msg);
+void broadcast_msg(Player *head, const Message *msg, Player *ignored_player);
+void broadcast_msg_ids(Player *head, const Message *msg, const Message *id_msg);
+void send_ret(Player *player, const char *verb, const char *code);
+void send_timer(Player *player, enum msg_type type, int seconds, uint64_t deadline);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include <stdint.h>
+
+#define DEFAULT_RATE_PER_SECOND 20  // Commandes par seconde et par connexion (rafale : le double)
+#define RATE_STRIKE_WINDOW_MS 10000 // Sans nouvel excès pendant ce délai, le compteur d'excès repart de zéro
+#define RATE_DELAY_STRIKES 10       // Tous les 10 excès, la lecture de la connexion est suspendue...
+#define RATE_DELAY_MS 2000          // ... 2 s de plus à chaque palier
+#define RATE_KICK_STRIKES 40        // Au-delà, déconnexion
+#define RATE_MAX_PENDING 65536      // Octets en attente tolérés pendant une suspension
+
+// Verbes limités individuellement (en plus de la limite de la connexion)
+enum rate_verb { RATE_LOGIN, RATE_PLAY, RATE_CHOICE, RATE_PROTO, RATE_PING, RATE_QUERY, RATE_VERB_COUNT };
+
+typedef struct Token_Bucket {
+	uint32_t tokens;  // En millièmes de jeton
+	uint64_t last;    // Dernier remplissage (clock_ms)
+} Token_Bucket;
+
+typedef struct Rate_State {
+	Token_Bucket conn;
+	Token_Bucket verbs[RATE_VERB_COUNT];
+	uint32_t strikes;       // Commandes refusées depuis la dernière accalmie
+	uint64_t last_strike;
+	uint64_t paused_until;  // Palier « retard » : commandes laissées en attente jusque-là (clock_ms)
+} Rate_State;
+
+/*
+ * Réponse graduée à un client trop bavard :
+ *  - RATE_DROP  : la commande est ignorée, sans réponse ni journal ;
+ *  - RATE_DELAY : idem, et ses commandes suivantes attendent paused_until ;
+ *  - RATE_KICK  : la connexion doit être fermée.
+ */
+enum rate_verdict { RATE_OK, RATE_DROP, RATE_DELAY, RATE_KICK };
+
+typedef struct Rate_Stats {
+	unsigned long dropped;
+	unsigned long delayed;
+	unsigned long kicked;
+} Rate_Stats;
+
+void rate_configure(uint32_t per_second);  // 0 : aucune limite
+void rate_init(Rate_State *state, uint64_t now);
+enum rate_verdict rate_check(Rate_State *state, const char *verb, uint64_t now);
+const Rate_Stats *rate_stats(void);
+
+#endif
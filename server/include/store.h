@@ -0,0 +1,36 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdbool.h>
+#include <time.h>
+
+#define DEFAULT_STORE_DIR "./data"  // Dossier des fichiers scores.log et matches.log
+#define STORE_FLUSH_INTERVAL 1      // Intervalle maximal entre deux écritures groupées (en secondes)
+#define STORE_COMPACT_MIN 1024      // Nombre minimal d'enregistrements avant compactage
+#define STORE_MAX_PATH 512          // Longueur maximale d'un chemin de fichier
+
+// Résultat d'une partie tel qu'il est historisé
+typedef struct Match_Result {
+	time_t finished_at;
+	const char *impostor;
+	const char *impostor_word;
+	const char *common_word;
+	const char *accused;      // Joueur le plus voté (NULL si aucun vote)
+	bool caught;              // L'imposteur a été démasqué
+	int player_count;
+	const char **usernames;
+	const int *gains;
+} Match_Result;
+
+/*
+ * Stockage en ajout seul : scores.log (variations de score, compacté périodiquement
+ * en totaux) et matches.log (historique des parties). Toute écriture disque est faite
+ * par un thread dédié, la boucle d'événements ne fait que mettre en file.
+ */
+bool store_open(const char *dir);
+int store_get_score(const char *username);
+void store_foreach(void (*fn)(const char *username, int score, int games, void *ctx), void *ctx);
+void store_record_match(const Match_Result *result);
+void store_close(void);
+
+#endif
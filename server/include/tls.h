@@ -0,0 +1,21 @@
+#ifndef TLS_H
+#define TLS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "player.h"
+
+enum tls_status { TLS_ERROR = -1, TLS_PENDING = 0, TLS_DONE = 1 };
+
+bool tls_init(const char *cert_file, const char *key_file);
+bool tls_enabled(void);
+bool tls_attach(Player *player);
+enum tls_status tls_handshake(Player *player);
+ssize_t tls_read(Player *player, void *buf, size_t len);
+ssize_t tls_write(Player *player, const void *buf, size_t len);
+bool tls_pending(Player *player);
+void tls_detach(Player *player);
+void tls_cleanup(void);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "player.h"
+
+#define URING_ENTRIES 256    // Taille de la file de soumission
+#define URING_BUF_COUNT 256  // Tampons de réception fournis au noyau (puissance de 2)
+#define URING_BUF_SIZE 4096  // Taille de chacun
+
+/*
+ * Moteur d'E/S io_uring (option -u), à la place de la boucle poll() : un accept
+ * multishot par socket d'écoute, un recv multishot par client qui puise dans un
+ * anneau de tampons fournis au noyau, et des envois regroupés (un seul
+ * io_uring_enter par tour de boucle pour tous les joueurs servis).
+ *
+ * Les joueurs restent les mêmes (Player, files in/out, add_player...) : seul le
+ * transport change. Un joueur retiré de la liste n'est libéré qu'une fois toutes
+ * ses opérations en vol terminées, le noyau pouvant encore écrire dans ses tampons.
+ *
+ * Indisponible (noyau trop ancien, seccomp...) : uring_init() échoue et le serveur
+ * garde poll(). Incompatible avec TLS, qui lit et écrit lui-même sur la socket.
+ */
+typedef struct Uring_Handlers {
+	Player *(*accepted)(int fd, enum transport transport); // NULL si la connexion est refusée
+	void (*received)(Player *p, const char *data, size_t len);
+	void (*closed)(Player *p);                             // Fin de connexion constatée
+	bool (*shed)(int listen_fd, enum transport transport); // Plus de descripteurs : refuser le premier en file
+} Uring_Handlers;
+
+bool uring_init(void);
+bool uring_enabled(void);
+void uring_listen(int fd, enum transport transport);
+void uring_recv(Player *p);
+void uring_send(Player *p);      // Appelé par player_flush : envoi au prochain uring_wait()
+void uring_release(Player *p);   // Joueur déjà retiré de la liste : libéré à la dernière complétion
+int uring_wait(int timeout_ms, const Uring_Handlers *handlers);
+void uring_cleanup(void);
+
+#endif
@@ -11,10 +11,10 @@ typedef struct Command{
     int param_count;
 } Command;
 
-void broadcast_message(Player *head, const char *message, Player *ignored_player);
 void log_message(const char *username, const char *message, const char *addr);
 void log_server_message(const char *username, const char *message, const char*addr);
 void to_lowercase(const char *src, char *dest, int max_len); // Fonction utilitaire : copie en minuscule
+size_t hash_username(const char *username); // Hachage insensible à la casse (index des scores, classement)
 Command *parse_input(const char *input);
 void print_command(Command *cmd);
 void free_command(Command *cmd);
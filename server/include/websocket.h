@@ -0,0 +1,26 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stddef.h>
+
+#include "buffer.h"
+#include "player.h"
+
+#define WS_MAX_PAYLOAD 65536  // Taille maximale d'un message WebSocket reçu
+#define WS_MAX_HANDSHAKE 4096 // Taille maximale de la requête HTTP d'upgrade
+
+enum ws_opcode {
+	WS_OP_CONTINUATION = 0x0,
+	WS_OP_TEXT         = 0x1,
+	WS_OP_BINARY       = 0x2,
+	WS_OP_CLOSE        = 0x8,
+	WS_OP_PING         = 0x9,
+	WS_OP_PONG         = 0xA
+};
+
+enum ws_status { WS_ERROR = -1, WS_OK = 0, WS_OPENED = 1 };
+
+void ws_encode_frame(Buffer *out, enum ws_opcode opcode, const void *data, size_t len);
+enum ws_status ws_process(Player *player);
+
+#endif
@@ -0,0 +1,43 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/buffer.h"
+
+// S'assure qu'au moins `extra` octets sont disponibles après les données
+bool buffer_reserve(Buffer *buf, size_t extra) {
+	if (buf->len + extra <= buf->cap) return true;
+
+	size_t new_cap = buf->cap ? buf->cap : 64;
+	while (new_cap < buf->len + extra) new_cap *= 2;
+
+	char *data = realloc(buf->data, new_cap);
+	if (!data) return false;
+
+	buf->data = data;
+	buf->cap = new_cap;
+	return true;
+}
+
+bool buffer_append(Buffer *buf, const void *data, size_t len) {
+	if (!buffer_reserve(buf, len)) return false;
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+	return true;
+}
+
+// Retire `len` octets en tête du tampon
+void buffer_consume(Buffer *buf, size_t len) {
+	if (len >= buf->len) {
+		buf->len = 0;
+		return;
+	}
+	memmove(buf->data, buf->data + len, buf->len - len);
+	buf->len -= len;
+}
+
+void buffer_free(Buffer *buf) {
+	free(buf->data);
+	buf->data = NULL;
+	buf->len = 0;
+	buf->cap = 0;
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -9,26 +10,171 @@
 #include "../include/game.h"
 #include "../include/player.h"
 #include "../include/utils.h"
+#include "../include/protocol.h"
+#include "../include/latency.h"
 
 static void send_word(Player *player, const char *word) {
-	char msg[BUFFER_SIZE];
-	snprintf(msg, sizeof(msg), "/assign %s\n", word);
-	send(player->fd, msg, strlen(msg), 0);
-	log_server_message(player->username, msg, player->addr);
+	Message msg;
+	msg_init(&msg, MSG_ASSIGN);
+	msg_add(&msg, word);
+	send_msg(player, &msg);
+	msg_free(&msg);
+}
+
+void start_phase_timer(Game_State *game, int seconds) {
+	game->phase_deadline = clock_ms() + (uint64_t)seconds * 1000;
+}
+
+// Secondes restantes (arrondies au-dessus) avant la fin de la phase
+int phase_remaining(const Game_State *game) {
+	uint64_t now = clock_ms();
+	if (now >= game->phase_deadline) return 0;
+	return (int)((game->phase_deadline - now + 999) / 1000);
+}
+
+// "/info GAME:round/max:joueurs:timing_play:timing_choice"
+void broadcast_game_info(Player *head, Game_State *game) {
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "GAME");
+	msg_addf(&msg, "%d/%d", game->current_round, game->max_rounds);
+	msg_addi(&msg, game->player_count);
+	msg_addi(&msg, game->timing_play);
+	msg_addi(&msg, game->timing_choice);
+	broadcast_msg(head, &msg, NULL);
+	msg_free(&msg);
+}
+
+// "/info WAIT:joueur:PLAY" à tous puis "/play N:ÉCHÉANCE" au joueur concerné
+void announce_turn(Player *head, Game_State *game, Player *turn_player) {
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "WAIT");
+	msg_add(&msg, turn_player->username);
+	msg_add(&msg, "PLAY");
+	broadcast_msg(head, &msg, NULL);
+	msg_free(&msg);
+
+	start_phase_timer(game, game->timing_play);
+	send_timer(turn_player, MSG_PLAY, game->timing_play, game->phase_deadline);
+}
+
+// Mode simultané : "/play N:ÉCHÉANCE" à tous les joueurs de la partie (ceux qui ont un mot)
+void announce_round(Player *head, Game_State *game) {
+	start_phase_timer(game, game->timing_play);
+	for (Player *p = head; p; p = p->next) {
+		if (p->secret_word[0]) send_timer(p, MSG_PLAY, game->timing_play, game->phase_deadline);
+	}
+}
+
+// Mode simultané : tous les joueurs de la partie ont joué leur mot du round
+bool round_complete(Player *head, Game_State *game) {
+	int eligible = 0;
+	for (Player *p = head; p; p = p->next) {
+		if (!p->secret_word[0]) continue;
+		eligible++;
+		if (!p->submitted_words[game->current_round - 1][0]) return false;
+	}
+	return eligible > 0;
+}
+
+// "/info SAY:joueur:mot" (ou "/info SAY:id:mot" pour les clients qui ont négocié les identifiants)
+static void broadcast_say(Player *head, Player *sender, const char *word) {
+	Message msg, id_msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "SAY");
+	msg_add(&msg, sender->username);
+	msg_add(&msg, word);
+
+	msg_init(&id_msg, MSG_INFO);
+	msg_add(&id_msg, "SAY");
+	msg_addi(&id_msg, sender->id);
+	msg_add(&id_msg, word);
+
+	broadcast_msg_ids(head, &msg, &id_msg);
+	msg_free(&msg);
+	msg_free(&id_msg);
+}
+
+// Mode simultané : les mots du round, gardés jusque-là dans submitted_words,
+// sont dévoilés ensemble ("/info SAY" pour chacun), puis round suivant ou vote
+void reveal_round(Player *head, Game_State *game) {
+	for (Player *p = head; p; p = p->next) {
+		const char *word = p->submitted_words[game->current_round - 1];
+		if (!p->secret_word[0] || !word[0]) continue;
+
+		add_played_word(game, word);
+
+		broadcast_say(head, p, word);
+	}
+
+	game->current_round++;
+	if (game->current_round > game->max_rounds) {
+		start_voting(head, game);
+	} else {
+		broadcast_game_info(head, game);
+		announce_round(head, game);
+	}
+}
+
+// Mode simultané : le mot attend la fin du round, seuls les rounds précédents comptent
+// comme déjà joués (refuser un doublon du round en cours trahirait le mot d'un autre)
+static void submit_round_word(Player *head, Game_State *game, Player *sender, const char *word) {
+	char *slot = sender->submitted_words[game->current_round - 1];
+	if (!sender->secret_word[0] || slot[0]) {
+		send_ret(sender, "PLAY", "102");
+		return;
+	}
+
+	if (is_word_played(game, word)) {
+		send_ret(sender, "PLAY", "103");
+		send_timer(sender, MSG_PLAY, phase_remaining(game), game->phase_deadline);
+		return;
+	}
+
+	if (!sender->binary && strchr(word, ':') != NULL) {
+		send_ret(sender, "PLAY", "108");
+		send_timer(sender, MSG_PLAY, phase_remaining(game), game->phase_deadline);
+		return;
+	}
+
+	strncpy(slot, word, MAX_WORD - 1);
+	slot[MAX_WORD - 1] = '\0';
+	log_message(sender->username, word, sender->addr);
+	send_ret(sender, "PLAY", "000");
+
+	if (round_complete(head, game)) reveal_round(head, game);
+}
+
+// Passage au vote : "/choice N:ÉCHÉANCE" à tous
+void start_voting(Player *head, Game_State *game) {
+	game->phase = VOTING;
+	game->votes_received = 0;
+	game->votes_complete = false;
+	start_phase_timer(game, game->timing_choice);
+
+	Message msg;
+	msg_init(&msg, MSG_CHOICE);
+	msg_addi(&msg, game->timing_choice);
+	msg_addf(&msg, "%llu", (unsigned long long)game->phase_deadline);
+	broadcast_msg(head, &msg, NULL);
+	msg_free(&msg);
 }
 
 void assign_words(Player *head, Game_State *game) {
-	char common_word[MAX_WORD], impostor_word[MAX_WORD], msg[BUFFER_SIZE];
+	char common_word[MAX_WORD], impostor_word[MAX_WORD];
 	select_random_words_from_csv("./data/words.csv", common_word, impostor_word);
 
 	game->impostor_idx = rand() % game->player_count;
 
 	int idx = 0;
+	uint64_t now = clock_ms();
 	Player *curr = head;
 	while (curr) {
 		const char *word = (idx++ == game->impostor_idx) ? impostor_word : common_word;
 		strncpy(curr->secret_word, word, MAX_WORD - 1);
 		curr->secret_word[MAX_WORD - 1] = '\0';
+		curr->last_activity = now; // L'attente dans le salon ne compte pas dans l'inactivité en partie
 		send_word(curr, word);
 		curr = curr->next;
 	}
@@ -36,18 +182,13 @@ void assign_words(Player *head, Game_State *game) {
 	game->phase = PLAYING;
 	game->current_turn = 0;
 	game->current_round = 1;
-	game->phase_start_time = time(NULL);
 
-	Player *turn_player = get_player_by_index(head, game->current_turn);
-	snprintf(msg, sizeof(msg), "/info GAME:%d/%d:%d:%d:%d\n", game->current_round, game->max_rounds, game->player_count, game->timing_play, game->timing_choice);
-	broadcast_message(head, msg, NULL);
-	
-	snprintf(msg, BUFFER_SIZE, "/info WAIT:%s:PLAY\n", turn_player->username);
-	broadcast_message(head, msg, NULL);
-	
-	snprintf(msg, BUFFER_SIZE, "/play %d\n", game->timing_play);
-	send(turn_player->fd, msg, strlen(msg), 0);
-	log_server_message(turn_player->username, msg, turn_player->addr);
+	broadcast_game_info(head, game);
+	if (game->simultaneous) {
+		announce_round(head, game);
+	} else {
+		announce_turn(head, game, get_player_by_index(head, game->current_turn));
+	}
 	
 	strcpy(game->common_word, common_word); 
 	strcpy(game->impostor_word, impostor_word); 
@@ -67,7 +208,7 @@ bool is_word_played(Game_State *game, const char *word) {
 }
 
 void add_played_word(Game_State *game, const char *word) {
-	Played_Word *new_word = malloc(sizeof(Played_Word));
+	Played_Word *new_word = arena_alloc(&game->arena, sizeof(Played_Word));
 	if (!new_word) return;
 
 	strncpy(new_word->word, word, MAX_WORD - 1);
@@ -77,47 +218,37 @@ void add_played_word(Game_State *game, const char *word) {
 }
 
 
+// Les mots vivent dans l'arène de la partie : libérés tous ensemble
 void free_played_words(Game_State *game) {
-	Played_Word *current = game->played_words;
-	while (current) {
-		Played_Word *next = current->next;
-		free(current);
-		current = next;
-	}
+	arena_reset(&game->arena);
 	game->played_words = NULL;
 }
 
 void handle_word_submission(Player *head, Game_State *game, Player *sender, const char *word) {
+	if (game->simultaneous) {
+		submit_round_word(head, game, sender, word);
+		return;
+	}
+
 	Player *turn_player = get_player_by_index(head, game->current_turn);
-	char msg[BUFFER_SIZE];
 	
 	if (sender != turn_player) {
-		strcpy(msg, "/ret PLAY:102\n");
-		send(sender->fd, msg, strlen(msg), 0);
-		log_server_message(sender->username, msg, sender->addr);
+		send_ret(sender, "PLAY", "102");
 		return;
 	}
 
 	
 	// Vérifier si le mot a déjà été joué
 	if (is_word_played(game, word)) {
-		strcpy(msg, "/ret PLAY:103\n");
-		send(sender->fd, msg, strlen(msg), 0);
-		log_server_message(sender->username, msg, sender->addr);
-		
-		snprintf(msg, BUFFER_SIZE, "/play %d\n", game->temps_restant);
-		send(sender->fd, msg, strlen(msg), 0);
-		log_server_message(sender->username, msg, sender->addr);
+		send_ret(sender, "PLAY", "103");
+		send_timer(sender, MSG_PLAY, phase_remaining(game), game->phase_deadline);
 		return;
 	}
 
-	if(strchr(word, ':') != NULL) {
-		strcpy(msg, "/ret PLAY:108\n");
-		send(sender->fd, msg, strlen(msg), 0);
-		log_server_message(sender->username, msg, sender->addr);
-
-		snprintf(msg, BUFFER_SIZE, "/play %d\n", game->temps_restant);
-		send(sender->fd, msg, strlen(msg), 0);
+	// Le ':' ne peut pas transiter en texte, seul le protocole binaire l'autorise
+	if(!sender->binary && strchr(word, ':') != NULL) {
+		send_ret(sender, "PLAY", "108");
+		send_timer(sender, MSG_PLAY, phase_remaining(game), game->phase_deadline);
 		return;
 	}
 
@@ -125,86 +256,97 @@ void handle_word_submission(Player *head, Game_State *game, Player *sender, cons
 	add_played_word(game, word);
 	strncpy(sender->submitted_words[game->current_round - 1], word, MAX_WORD - 1);
 
-	snprintf(msg, BUFFER_SIZE,"/info SAY:%s:%s\n", sender->username, word);
-	broadcast_message(head, msg, NULL);
+	broadcast_say(head, sender, word);
 
 	log_message(sender->username, word, sender->addr);
 
-	strcpy(msg, "/ret PLAY:000\n");
-	send(sender->fd, msg, strlen(msg), 0);
-	log_server_message(sender->username, msg, sender->addr);
-
-	game->phase_start_time = time(NULL);
+	send_ret(sender, "PLAY", "000");
 
 	if (++game->current_turn >= game->player_count) {
 		game->current_turn = 0;
 		game->current_round++;
 
 		if(game->current_round <= game->max_rounds) {
-			snprintf(msg, sizeof(msg), "/info GAME:%d/%d:%d:%d:%d\n", game->current_round, game->max_rounds, game->player_count, game->timing_play, game->timing_choice);
-			broadcast_message(head, msg, NULL);
+			broadcast_game_info(head, game);
 		}
 	}
 
 	if (game->current_round > game->max_rounds) {
-		game->phase = VOTING;
-		game->votes_received = 0;
-		game->phase_start_time = time(NULL);
-
-		snprintf(msg, sizeof(msg), "/choice %d\n", game->timing_choice);
-		broadcast_message(head, msg, NULL);
+		start_voting(head, game);
 	} else {
-		Player *next_turn = get_player_by_index(head, game->current_turn);
-
-		snprintf(msg, sizeof(msg), "/info WAIT:%s:PLAY\n", next_turn->username);
-		broadcast_message(head, msg, NULL);
-
-		snprintf(msg, sizeof(msg), "/play %d\n", game->timing_play);
-		send(next_turn->fd, msg, strlen(msg), 0);
-		log_server_message(next_turn->username, msg, next_turn->addr);
-
-		game->phase_start_time = time(NULL);
+		announce_turn(head, game, get_player_by_index(head, game->current_turn));
 	}
 }
 
 void handle_vote(Player *head, Game_State *game, Player *voter, const char *vote) {
-	Player *target = get_player_by_username(head, vote);
-	char msg[BUFFER_SIZE];
+	Player *target = find_player(head, game, voter, vote);
 	
-	if (!target) {
-		strcpy(msg, "/ret CHOICE:106\n");
-		send(voter->fd, msg, strlen(msg), 0);
-		log_server_message(voter->username, msg, voter->addr);
-
-		snprintf(msg, BUFFER_SIZE, "/choice %d\n", game->temps_restant);
-		send(voter->fd, msg, strlen(msg), 0);
-		log_server_message(voter->username, msg, voter->addr);
+	if (!target || target->id < 0) {
+		send_ret(voter, "CHOICE", "106");
+		send_timer(voter, MSG_CHOICE, phase_remaining(game), game->phase_deadline);
 		return;
 	}
 
 	if(target == voter) {
-		strcpy(msg, "/ret CHOICE:105\n");
-		send(voter->fd, msg, strlen(msg), 0);
-		log_server_message(voter->username, msg, voter->addr);
-
-		snprintf(msg, BUFFER_SIZE, "/choice %d\n", game->temps_restant);
-		send(voter->fd, msg, strlen(msg), 0);
-		log_server_message(voter->username, msg, voter->addr);
+		send_ret(voter, "CHOICE", "105");
+		send_timer(voter, MSG_CHOICE, phase_remaining(game), game->phase_deadline);
 		return;
 	}
 
-	strncpy(voter->vote, target->username, MAX_USERNAME - 1);
-	log_message(voter->username, target->username, voter->addr);
-	if(!voter->vote) {
+	// Premier vote de ce joueur (les suivants ne font que changer d'avis)
+	if (!voter->voted) {
 		game->votes_received++;
+		voter->voted = true;
 	}
+	voter->vote = target->id;
+	log_message(voter->username, target->username, voter->addr);
 
-	char info_msg[BUFFER_SIZE];
-	snprintf(info_msg, sizeof(info_msg), "/info CHOICE:%s:%s\n", voter->username, target->username);
-	broadcast_message(head, info_msg, NULL);
-	snprintf(msg, sizeof(msg), "/choice %d\n", game->temps_restant);
-	send(voter->fd, msg, strlen(msg), 0);
-	log_server_message(voter->username, msg, voter->addr);
+	Message msg, id_msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "CHOICE");
+	msg_add(&msg, voter->username);
+	msg_add(&msg, target->username);
+
+	msg_init(&id_msg, MSG_INFO);
+	msg_add(&id_msg, "CHOICE");
+	msg_addi(&id_msg, voter->id);
+	msg_addi(&id_msg, target->id);
+
+	broadcast_msg_ids(head, &msg, &id_msg);
+	msg_free(&msg);
+	msg_free(&id_msg);
+
+	send_timer(voter, MSG_CHOICE, phase_remaining(game), game->phase_deadline);
+	check_votes_complete(head, game);
+}
+
+// Tous les joueurs de la partie (ceux qui ont reçu un mot) ont voté : inutile
+// d'attendre la fin du temps, les résultats tombent après l'éventuel délai de grâce
+void check_votes_complete(Player *head, Game_State *game) {
+	if (game->phase != VOTING || game->votes_complete) return;
+
+	int eligible = 0, voted = 0;
+	for (Player *p = head; p; p = p->next) {
+		if (!p->secret_word[0]) continue;
+		eligible++;
+		if (p->voted) voted++;
+	}
+	if (eligible == 0 || voted < eligible) return;
+
+	game->votes_complete = true;
+	uint64_t deadline = clock_ms() + (uint64_t)game->vote_grace * 1000;
+	if (deadline >= game->phase_deadline) return;
+	game->phase_deadline = deadline;
+
+	// Les comptes à rebours des clients suivent la nouvelle échéance
+	if (game->vote_grace > 0) {
+		Message msg;
+		msg_init(&msg, MSG_CHOICE);
+		msg_addi(&msg, phase_remaining(game));
+		msg_addf(&msg, "%llu", (unsigned long long)game->phase_deadline);
+		broadcast_msg(head, &msg, NULL);
+		msg_free(&msg);
+	}
 }
 
 void reset_game(Game_State *game, Player *head) {
@@ -214,6 +356,7 @@ void reset_game(Game_State *game, Player *head) {
 	game->current_turn = 0;
 	game->current_round = 1;
 	game->votes_received = 0;
+	game->votes_complete = false;
 	memset(game->common_word, 0, MAX_WORD);
 	memset(game->impostor_word, 0, MAX_WORD);
 
@@ -224,9 +367,100 @@ void reset_game(Game_State *game, Player *head) {
 		head->secret_word[0] = '\0';
 		for (int j = 0; j < game->max_rounds; j++)
 			head->submitted_words[j][0] = '\0';
-		head->vote[0] = '\0';
+		head->vote = -1;
+		head->voted = false;
 		head = head->next;
 		count++;
 	}
 	game->player_count = count;
-}
\ No newline at end of file
+}
+bool tally_init(Vote_Tally *tally, int capacity) {
+	*tally = (Vote_Tally){
+		.capacity = capacity,
+		.counts = calloc(capacity, sizeof(int)),
+		.old_scores = calloc(capacity, sizeof(int)),
+		.gains = calloc(capacity, sizeof(int)),
+		.usernames = calloc(capacity, sizeof(const char *))
+	};
+	if (!tally->counts || !tally->old_scores || !tally->gains || !tally->usernames) {
+		tally_free(tally);
+		return false;
+	}
+	return true;
+}
+
+// Remet les compteurs à zéro et relève noms et scores dans l'ordre de la liste ; renvoie le nombre de joueurs
+int tally_index(Vote_Tally *tally, Player *head) {
+	memset(tally->counts, 0, tally->capacity * sizeof(int));
+
+	int count = 0;
+	for (Player *curr = head; curr && count < tally->capacity; curr = curr->next, count++) {
+		tally->gains[count] = 0;
+		tally->old_scores[count] = curr->score;
+		tally->usernames[count] = curr->username;
+	}
+	return count;
+}
+
+void tally_free(Vote_Tally *tally) {
+	free(tally->counts);
+	free(tally->old_scores);
+	free(tally->gains);
+	free(tally->usernames);
+	*tally = (Vote_Tally){0};
+}
+
+// Plus petit identifiant libre : les identifiants restent denses, un vote est un indice de tableau
+int roster_add(Game_State *game, Player *player) {
+	for (int id = 0; id < game->max_players; id++) {
+		if (!game->roster[id]) {
+			game->roster[id] = player;
+			player->id = id;
+			return id;
+		}
+	}
+	return -1;
+}
+
+// Libère l'identifiant du joueur ; ceux qui avaient voté pour lui doivent revoter
+void roster_remove(Player *head, Game_State *game, Player *player) {
+	if (player->id < 0) return;
+	game->roster[player->id] = NULL;
+	for (Player *p = head; p; p = p->next) {
+		if (p == player || p->vote != player->id) continue;
+		p->vote = -1;
+		if (p->voted) {
+			p->voted = false;
+			game->votes_received--;
+		}
+		if (game->phase == VOTING) {
+			send_timer(p, MSG_CHOICE, phase_remaining(game), game->phase_deadline);
+		}
+	}
+	player->id = -1;
+}
+
+Player *roster_get(const Game_State *game, int id) {
+	return id >= 0 && id < game->max_players ? game->roster[id] : NULL;
+}
+
+// Forme réservée aux identifiants (des chiffres, éventuellement précédés d'un signe) : refusée comme nom au /login
+bool looks_like_id(const char *text) {
+	if (text[0] == '-' || text[0] == '+') text++;
+	if (!text[0]) return false;
+	for (const char *c = text; *c; c++) {
+		if (*c < '0' || *c > '9') return false;
+	}
+	return true;
+}
+
+// Joueur désigné par une commande : identifiant pour les clients qui les ont négociés, nom sinon (et toujours accepté)
+Player *find_player(Player *head, const Game_State *game, const Player *sender, const char *name_or_id) {
+	if (sender->ids && looks_like_id(name_or_id)) {
+		char *end;
+		long id = strtol(name_or_id, &end, 10);
+		Player *p = *end == '\0' && id >= 0 && id < game->max_players ? roster_get(game, (int)id) : NULL;
+		if (p) return p;
+	}
+	return get_player_by_username(head, name_or_id);
+}
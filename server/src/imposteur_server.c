@@ -1,18 +1,29 @@
+#define _GNU_SOURCE
 #include <poll.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <getopt.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 #include <signal.h>
+#include <fcntl.h>
 
 #include "../include/game.h"
 #include "../include/player.h"
 #include "../include/utils.h"
+#include "../include/protocol.h"
+#include "../include/websocket.h"
+#include "../include/tls.h"
+#include "../include/store.h"
+#include "../include/leaderboard.h"
+#include "../include/latency.h"
+#include "../include/uring.h"
 #include "../include/config.h"
 #include "../include/color.h"
 
@@ -25,65 +36,47 @@
 "          \\/|__|              \\/            \\/              \n\n" \
 
 static int server_fd = -1;
+static int ws_fd = -1;
+static int listen_count = 1;   // Sockets d'écoute en tête de pollfds (TCP, puis WebSocket)
 static struct pollfd *pollfds = NULL;
 static Player *players = NULL;
 static Game_State game;
 
-static char msg_buffer[BUFFER_SIZE];
-static char temp_buffer[BUFFER_SIZE];
+static int max_per_ip = DEFAULT_MAX_PER_IP;
+static int spare_fd = -1;      // Descripteur de réserve : libéré pour refuser un client quand il n'en reste plus
 
-// Handler pour nettoyage propre à l'arrêt
-void cleanup_handler(int sig) {
-	printf("\nArrêt du serveur...\n");
-	if (pollfds) free(pollfds);
-	if (server_fd >= 0) close(server_fd);
-	exit(0);
-}
+// Connexions fermées par le serveur faute d'activité (affichées à l'arrêt)
+static struct {
+	unsigned long login;  // Jamais identifiées dans le délai (slowloris, scanners...)
+	unsigned long idle;   // Plus aucune commande depuis IDLE_TIMEOUT
+} evictions;
 
-// Optimisation: fonction inline pour éviter les appels répétés
-static inline time_t get_current_time() {
-	return time(NULL);
-}
+static bool debug = false;
+static volatile sig_atomic_t stop_requested = 0;
 
-// Optimisation: cache pour éviter les recalculs répétés
-static inline int calculate_remaining_time(time_t start_time, int duration) {
-	return duration - (int)(get_current_time() - start_time);
+// Handler d'arrêt : la boucle principale se termine et fait le nettoyage (historique compris)
+void cleanup_handler(int sig) {
+	stop_requested = 1;
 }
 
-// Fonction optimisée pour la gestion des votes
+// Dépouillement dans les tampons de la salle (game->tally), dimensionnés par -j
 static void process_voting_results(Player *players, Game_State *game) {
-	static int counts[MAX_PLAYERS]; // Statique pour éviter la réallocation
-	static int old_scores[MAX_PLAYERS];
-	static int gains[MAX_PLAYERS];
-	
-	// Reset des compteurs
-	memset(counts, 0, sizeof(counts));
-	memset(gains, 0, sizeof(gains));
-	
-	// Compter les votes de manière optimisée
-	int player_idx = 0;
+	Vote_Tally *tally = &game->tally;
+	int *counts = tally->counts;
+	int *gains = tally->gains;
+
+	// Chaque vote est un identifiant : compté directement à son indice
+	int count = tally_index(tally, players);
 	for (Player *curr = players; curr; curr = curr->next) {
-		old_scores[player_idx++] = curr->score;
-		
-		if (curr->vote[0] == '\0') continue; // Vote vide
-		
-		Player *voted = get_player_by_username(players, curr->vote);
-		if (!voted) continue;
-
-		// Trouver l'index du joueur voté
-		int voted_idx = 0;
-		for (Player *temp = players; temp && temp != voted; temp = temp->next) {
-			voted_idx++;
-		}
-		counts[voted_idx]++;
+		if (curr->vote >= 0) counts[curr->vote]++;
 	}
 
-	// Trouver le joueur le plus voté
-	int max_votes = 0, voted_idx = -1;
-	for (int i = 0; i < game->player_count; i++) {
-		if (counts[i] > max_votes) {
-			max_votes = counts[i];
-			voted_idx = i;
+	// Trouver le joueur le plus voté (le premier de la liste en cas d'égalité)
+	int max_votes = 0, voted_idx = -1, idx = 0;
+	for (Player *curr = players; curr && idx < count; curr = curr->next, idx++) {
+		if (curr->id >= 0 && counts[curr->id] > max_votes) {
+			max_votes = counts[curr->id];
+			voted_idx = idx;
 		}
 	}
 
@@ -91,18 +84,18 @@ static void process_voting_results(Player *players, Game_State *game) {
 	Player *voted_player = get_player_by_index(players, voted_idx);
 
 	// Mise à jour optimisée des scores
-	int idx = 0;
+	idx = 0;
 	if (voted_idx == game->impostor_idx) {
-		// L'imposteur a été démasqué
-		for (Player *curr = players; curr; curr = curr->next, idx++) {
-			if (curr != impostor_player) {
+		// L'imposteur a été démasqué (les joueurs arrivés en cours de partie n'ont pas joué)
+		for (Player *curr = players; curr && idx < count; curr = curr->next, idx++) {
+			if (curr != impostor_player && curr->secret_word[0]) {
 				curr->score += 2;
 				gains[idx] = 2;
 			}
 		}
 	} else {
 		// L'imposteur n'a pas été démasqué
-		for (Player *curr = players; curr; curr = curr->next, idx++) {
+		for (Player *curr = players; curr && idx < count; curr = curr->next, idx++) {
 			if (curr == impostor_player) {
 				curr->score += 3;
 				gains[idx] = 3;
@@ -111,110 +104,245 @@ static void process_voting_results(Player *players, Game_State *game) {
 		}
 	}
 
-	// Construction optimisée du message RESULT
-	char *ptr = msg_buffer;
-	ptr += sprintf(ptr, "/info RESULT:");
-	
+	// Envoyer les résultats
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ANSWER");
+	msg_add(&msg, impostor_player->username);
+	msg_add(&msg, game->impostor_word);
+	msg_add(&msg, game->common_word);
+	broadcast_msg(players, &msg, NULL);
+	msg_free(&msg);
+
+	// Construction du message RESULT (par nom, et par identifiant pour les clients qui les ont négociés)
+	Message id_msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "RESULT");
+	msg_init(&id_msg, MSG_INFO);
+	msg_add(&id_msg, "RESULT");
 	idx = 0;
-	for (Player *curr = players; curr; curr = curr->next, idx++) {
-		int remaining = BUFFER_SIZE - (ptr - msg_buffer);
-		if (remaining < MAX_USERNAME + 20) break; // Protection contre overflow
-		
-		ptr += snprintf(ptr, remaining, "%s:%d+%d", curr->username, old_scores[idx], gains[idx]);
-		if (curr->next) *ptr++ = ':';
+	for (Player *curr = players; curr && idx < count; curr = curr->next, idx++) {
+		msg_add(&msg, tally->usernames[idx]);
+		msg_addf(&msg, "%d+%d", tally->old_scores[idx], gains[idx]);
+		if (curr->id < 0) continue;
+		msg_addi(&id_msg, curr->id);
+		msg_addf(&id_msg, "%d+%d", tally->old_scores[idx], gains[idx]);
 	}
-	*ptr++ = '\n';
-	*ptr = '\0';
+	broadcast_msg_ids(players, &msg, &id_msg);
+	msg_free(&msg);
+	msg_free(&id_msg);
 
-	// Envoyer les résultats
-	snprintf(temp_buffer, sizeof(temp_buffer), "/info ANSWER:%s:%s:%s\n", impostor_player->username, game->impostor_word, game->common_word);
-	broadcast_message(players, temp_buffer, NULL);
-	broadcast_message(players, msg_buffer, NULL);
-}
+	// Seuls les joueurs qui ont reçu un mot ont joué la partie : les autres (arrivés en
+	// cours de route) sont retirés des tampons, qui ne servent plus, avant l'historisation
+	int played = 0;
+	idx = 0;
+	for (Player *curr = players; curr && idx < count; curr = curr->next, idx++) {
+		if (!curr->secret_word[0]) continue;
+		tally->usernames[played] = tally->usernames[idx];
+		gains[played] = gains[idx];
+		played++;
 
-// Fonction optimisée pour gérer les nouvelles connexions
-static int handle_new_connection(int server_fd, struct pollfd *pollfds, int *nfds, Player **players, Game_State *game) {
-	struct sockaddr_in client_addr;
-	socklen_t client_len = sizeof(client_addr);
-	int client_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
-	
-	if (client_fd < 0) {
-		if (errno != EWOULDBLOCK && errno != EAGAIN) {
-			perror("accept");
-		}
-		return -1;
+		// Classement global : seuls les joueurs de la table changent de place
+		leaderboard_update(curr->username, curr->score);
 	}
 
-	if (*nfds >= game->max_players + 1) {
-		close(client_fd);
-		return -1;
+	// Historisation (écriture différée, hors de la boucle d'événements)
+	store_record_match(&(Match_Result){
+		.finished_at = time(NULL),
+		.impostor = impostor_player->username,
+		.impostor_word = game->impostor_word,
+		.common_word = game->common_word,
+		.accused = voted_player ? voted_player->username : NULL,
+		.caught = voted_idx == game->impostor_idx,
+		.player_count = played,
+		.usernames = tally->usernames,
+		.gains = gains
+	});
+}
+
+static void broadcast_alert(Player *players, const char *text) {
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ALERT");
+	msg_add(&msg, text);
+	broadcast_msg(players, &msg, NULL);
+	msg_free(&msg);
+}
+
+static void send_alert(Player *p, const char *text) {
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ALERT");
+	msg_add(&msg, text);
+	send_msg(p, &msg);
+	msg_free(&msg);
+}
+
+static void send_greeting(Player *p) {
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ID");
+	msg_add(&msg, "Serveur Imposteur Super Cool");
+	send_msg(p, &msg);
+	msg_free(&msg);
+
+	msg_init(&msg, MSG_LOGIN);
+	send_msg(p, &msg);
+	msg_free(&msg);
+}
+
+// Refus poli plutôt qu'une fermeture muette : le client affiche la raison (et réessaie plus tard)
+static void refuse_client(int client_fd, enum transport transport, const char *reason) {
+	// En TLS, rien ne peut être dit avant la fin du handshake
+	if (!tls_enabled()) {
+		Buffer out = {0};
+		if (transport == TRANSPORT_WS) {
+			// Requête d'upgrade lue d'abord : fermer sur des octets non lus enverrait un RST
+			char request[BUFFER_SIZE];
+			while (recv(client_fd, request, sizeof(request), MSG_DONTWAIT) > 0);
+
+			char response[BUFFER_SIZE * 2];
+			int len = snprintf(response, sizeof(response),
+				"HTTP/1.1 503 Service Unavailable\r\nRetry-After: %d\r\nContent-Type: text/plain; charset=utf-8\r\n"
+				"Content-Length: %zu\r\nConnection: close\r\n\r\n%s", RETRY_AFTER_SECONDS, strlen(reason), reason);
+			buffer_append(&out, response, len);
+		} else {
+			Message msg;
+			msg_init(&msg, MSG_INFO);
+			msg_add(&msg, "ALERT");
+			msg_add(&msg, reason);
+			msg_encode_text(&msg, &out);
+			msg_free(&msg);
+		}
+		send(client_fd, out.data, out.len, MSG_NOSIGNAL | MSG_DONTWAIT);
+		buffer_free(&out);
+		shutdown(client_fd, SHUT_WR);
 	}
+	close(client_fd);
+}
 
+// Inscription d'un client accepté (poll ou io_uring) ; NULL s'il est refusé
+static Player *register_client(int client_fd, enum transport transport, const struct sockaddr_in *client_addr) {
 	// Optimisation: préparation de l'adresse en une seule fois
 	char ip[INET_ADDRSTRLEN];
-	inet_ntop(AF_INET, &client_addr.sin_addr, ip, sizeof(ip));
-	int port = ntohs(client_addr.sin_port);
+	inet_ntop(AF_INET, &client_addr->sin_addr, ip, sizeof(ip));
+	int port = ntohs(client_addr->sin_port);
 
 	char addr[MAX_ADDR];
 	snprintf(addr, MAX_ADDR, "%s:%d", ip, port);
-	log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown", "Waiting for username.", addr);
 
-	pollfds[*nfds].fd = client_fd;
-	pollfds[*nfds].events = POLLIN;
-	(*nfds)++;
+	// Limite globale (la table des joueurs) puis limite par adresse
+	char reason[BUFFER_SIZE];
+	bool loopback = (ntohl(client_addr->sin_addr.s_addr) >> 24) == 127;
+	if (count_players(players) >= game.max_players) {
+		snprintf(reason, sizeof(reason), "Serveur plein (%d/%d joueurs), réessayez plus tard.", game.max_players, game.max_players);
+	} else if (max_per_ip > 0 && !loopback && count_players_from(players, client_addr->sin_addr.s_addr) >= max_per_ip) {
+		snprintf(reason, sizeof(reason), "Trop de connexions depuis votre adresse (%d au maximum).", max_per_ip);
+	} else {
+		reason[0] = '\0';
+	}
+	if (reason[0]) {
+		log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Refused", reason, addr);
+		refuse_client(client_fd, transport, reason);
+		return NULL;
+	}
+
+	log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown", transport == TRANSPORT_WS ? "Waiting for WebSocket handshake." : "Waiting for username.", addr);
 
-	Player *new_p = add_player(players, client_fd, game);
+	Player *new_p = add_player(&players, client_fd, &game);
+	if (!new_p) {
+		close(client_fd);
+		return NULL;
+	}
+
+	// Sans session TLS, le handshake serait lu comme des commandes et les réponses partiraient en clair
+	if (tls_enabled() && !tls_attach(new_p)) {
+		log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Refused", "Impossible de créer la session TLS.", addr);
+		remove_player(&players, client_fd, &game);
+		return NULL;
+	}
+
+	// Les messages sont déjà regroupés par tour de boucle (player_cork) : Nagle n'aurait qu'à retarder le suivant
+	int nodelay = 1;
+	setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
 	strcpy(new_p->addr, addr);
-	game->player_count++;
+	new_p->ip = client_addr->sin_addr.s_addr;
+	new_p->transport = transport;
+	game.player_count++;
 
-	// Optimisation: messages pré-formatés
-	static const char info_msg[] = "/info ID:Serveur Imposteur Super Cool\n";
-	static const char login_msg[] = "/login\n";
-	
-	send(client_fd, info_msg, sizeof(info_msg) - 1, 0);
-	log_server_message("Unknown", info_msg, new_p->addr);
-	
-	send(client_fd, login_msg, sizeof(login_msg) - 1, 0);
-	log_server_message("Unknown", login_msg, new_p->addr);
-	
-	return client_fd;
+	// En TLS l'accueil attend la fin du handshake, en WebSocket celle de l'upgrade HTTP
+	if (!tls_enabled() && transport == TRANSPORT_TCP) {
+		send_greeting(new_p);
+	}
+
+	return new_p;
+}
+
+// Plus aucun descripteur libre : la réserve permet d'accepter le client en tête de file
+// pour le refuser, sinon il resterait dans le backlog et poll() réveillerait la boucle sans fin
+static bool shed_connection(int listen_fd, enum transport transport) {
+	if (spare_fd < 0) return false;
+	close(spare_fd);
+	int client_fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (client_fd >= 0) refuse_client(client_fd, transport, "Serveur surchargé, réessayez plus tard.");
+	spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	return client_fd >= 0;
+}
+
+// Nouvelles connexions (TCP ou WebSocket) : toute la file d'attente du listener à chaque réveil
+static void handle_new_connections(int listen_fd, enum transport transport, int *nfds) {
+	for (;;) {
+		struct sockaddr_in client_addr;
+		socklen_t client_len = sizeof(client_addr);
+		// Les envois passent par la file de sortie du joueur : jamais de send() bloquant
+		int client_fd = accept4(listen_fd, (struct sockaddr*)&client_addr, &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (client_fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			if ((errno == EMFILE || errno == ENFILE) && shed_connection(listen_fd, transport)) continue;
+			if (errno != EWOULDBLOCK && errno != EAGAIN) {
+				perror("accept");
+			}
+			return;
+		}
+
+		if (!register_client(client_fd, transport, &client_addr)) continue;
+
+		pollfds[*nfds].fd = client_fd;
+		pollfds[*nfds].events = POLLIN;
+		(*nfds)++;
+	}
 }
 
 // Fonction optimisée pour la gestion de la phase de jeu
 static void handle_playing_phase(Player *players, Game_State *game) {
-	int temps_restant = calculate_remaining_time(game->phase_start_time, game->timing_play);
-	game->temps_restant = temps_restant;
+	game->temps_restant = phase_remaining(game);
+
+	// Mode simultané : dévoilement à l'échéance, ou plus tôt si le dernier à jouer est parti
+	if (game->simultaneous) {
+		if (clock_ms() >= game->phase_deadline || round_complete(players, game)) {
+			reveal_round(players, game);
+		}
+		return;
+	}
 
-	if (temps_restant <= 0) {
+	if (clock_ms() >= game->phase_deadline) {
 		game->current_turn++;
 		if (game->current_turn >= game->player_count) {
 			game->current_turn = 0;
 			game->current_round++;
 			
 			if (game->current_round <= game->max_rounds) {
-				snprintf(msg_buffer, BUFFER_SIZE, "/info GAME:%d/%d:%d:%d:%d\n", 
-						game->current_round, game->max_rounds, game->player_count, 
-						game->timing_play, game->timing_choice);
-				broadcast_message(players, msg_buffer, NULL);
+				broadcast_game_info(players, game);
 			}
 		}
 
 		if (game->current_round > game->max_rounds) {
-			game->phase = VOTING;
-			snprintf(msg_buffer, BUFFER_SIZE, "/choice %d\n", game->timing_choice);
-			broadcast_message(players, msg_buffer, NULL);
-			game->votes_received = 0;
-			game->phase_start_time = get_current_time();
+			start_voting(players, game);
 		} else {
 			Player *next_turn = get_player_by_index(players, game->current_turn);
 			if (next_turn) {
-				snprintf(msg_buffer, BUFFER_SIZE, "/info WAIT:%s:PLAY\n", next_turn->username);
-				broadcast_message(players, msg_buffer, NULL);
-
-				snprintf(temp_buffer, BUFFER_SIZE, "/play %d\n", game->timing_play);
-				send(next_turn->fd, temp_buffer, strlen(temp_buffer), 0);
-				log_server_message(next_turn->username, temp_buffer, next_turn->addr);
-				game->phase_start_time = get_current_time();
+				announce_turn(players, game, next_turn);
 			}
 		}
 	}
@@ -222,35 +350,554 @@ static void handle_playing_phase(Player *players, Game_State *game) {
 
 // Fonction optimisée pour la gestion de la phase de vote
 static void handle_voting_phase(Player *players, Game_State *game) {
-	int temps_restant = calculate_remaining_time(game->phase_start_time, game->timing_choice);
-	game->temps_restant = temps_restant;
+	// Un joueur qui n'avait pas voté a pu partir entre-temps
+	check_votes_complete(players, game);
+	game->temps_restant = phase_remaining(game);
 
-	if (temps_restant <= 0) {
+	if (clock_ms() >= game->phase_deadline) {
 		process_voting_results(players, game);
 		game->phase = RESULTS;
+		start_phase_timer(game, TIMING_BETWEEN_GAMES);
+	}
+}
 
-		sleep(TIMING_BETWEEN_GAMES);
+// Pause entre deux parties, sans bloquer la boucle : les résultats partent (io_uring
+// n'envoie qu'au tour suivant) et les connexions restent servies pendant l'attente
+static void handle_results_phase(Player *players, Game_State *game) {
+	if (clock_ms() >= game->phase_deadline) {
 		reset_game(game, players);
 
 		if (game->player_count >= MIN_PLAYERS) {
-			broadcast_message(players, "/info ALERT:Début de la partie ! Attribution des mots...\n", NULL);
+			broadcast_alert(players, "Début de la partie ! Attribution des mots...");
 			game->phase = ASSIGNING_WORDS;
 			assign_words(players, game);
 		} else {
-			broadcast_message(players, "/info ALERT:En attente d'autres joueurs...\n", NULL);
+			broadcast_alert(players, "En attente d'autres joueurs...");
+		}
+	}
+}
+
+// Départ d'un joueur : retrait de la partie et annonce aux autres
+static void drop_player(Player *p) {
+	char name[MAX_USERNAME];
+	strcpy(name, p->username[0] ? p->username : "Unknown");
+
+	log_message(p->username[0] ? p->username : ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown" ANSI_RESET_ALL, 
+			ANSI_COLOR_RED ANSI_STYLE_BOLD "Disconnected" ANSI_RESET_ALL, p->addr);
+	if (p->rtt.samples) {
+		char rtt[BUFFER_SIZE];
+		snprintf(rtt, sizeof(rtt), "RTT lissé %u ms (min %u, max %u, %u mesures)", p->rtt.srtt, p->rtt.min, p->rtt.max, p->rtt.samples);
+		log_message(name, rtt, p->addr);
+	}
+
+	roster_remove(players, &game, p);
+
+	if (uring_enabled()) {
+		// Le noyau peut encore tenir ses tampons : libéré à la dernière complétion
+		unlink_player(&players, p);
+		uring_release(p);
+	} else {
+		remove_player(&players, p->fd, &game);
+	}
+	game.player_count--;
+
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ALERT");
+	msg_addf(&msg, "%s s'est déconnecté.", name);
+	broadcast_msg(players, &msg, NULL);
+	msg_free(&msg);
+
+	if (game.phase != WAITING && game.player_count < MIN_PLAYERS) {
+		broadcast_alert(players, "Un joueur s'est déconnecté. Le jeu a été interrompu. En attente d'autres joueurs...");
+		reset_game(&game, players);
+	}
+}
+
+// Déconnexion d'un client et compactage de pollfds
+static void disconnect_client(int i, int *nfds) {
+	Player *p = get_player_by_fd(players, pollfds[i].fd);
+	pollfds[i] = pollfds[*nfds - 1];
+	(*nfds)--;
+	drop_player(p);
+}
+
+// "/info ROSTER:id:joueur:..." : tous les joueurs identifiés, une fois, au client qui négocie les identifiants
+static void send_roster(Player *p) {
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ROSTER");
+	for (int id = 0; id < game.max_players; id++) {
+		Player *curr = roster_get(&game, id);
+		if (!curr) continue;
+		msg_addi(&msg, id);
+		msg_add(&msg, curr->username);
+	}
+	send_msg(p, &msg);
+	msg_free(&msg);
+}
+
+static void handle_login(Player *p, const char *username) {
+	if (p->username_set) {
+		send_ret(p, "LOGIN", "202");
+		return;
+	}
+
+	// Validation optimisée (le ':' n'est interdit qu'en protocole texte)
+	bool invalid = !username || strlen(username) < MIN_USERNAME || (!p->binary && strchr(username, ':') != NULL)
+		|| looks_like_id(username); // Un nom tout en chiffres se confondrait avec un identifiant (/proto ID)
+	for (const char *c = username; !invalid && *c; c++) {
+		if ((unsigned char)*c < 0x20) invalid = true;
+	}
+
+	if (invalid || get_player_by_username(players, username)) {
+		send_ret(p, "LOGIN", invalid ? "107" : "101");
+
+		Message msg;
+		msg_init(&msg, MSG_LOGIN);
+		send_msg(p, &msg);
+		msg_free(&msg);
+		return;
+	}
+
+	strncpy(p->username, username, MAX_USERNAME - 1);
+	p->username[MAX_USERNAME - 1] = '\0';
+	p->username_set = true;
+	p->ready = true;
+	p->score = store_get_score(p->username);
+	roster_add(&game, p);
+
+	log_message(p->username, ANSI_COLOR_GREEN ANSI_STYLE_BOLD "Connected" ANSI_RESET_ALL, p->addr);
+	send_ret(p, "LOGIN", "000");
+
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "LOGIN");
+	msg_addf(&msg, "%d/%d", count_ready_players(players), game.max_players);
+	msg_add(&msg, p->username);
+	broadcast_msg(players, &msg, NULL);
+	msg_free(&msg);
+
+	// Les clients qui ont négocié les identifiants apprennent celui du nouveau venu
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "ROSTER");
+	msg_addi(&msg, p->id);
+	msg_add(&msg, p->username);
+	for (Player *curr = players; curr; curr = curr->next) {
+		if (curr->ids) send_msg(curr, &msg);
+	}
+	msg_free(&msg);
+	
+	if (game.phase == WAITING && all_players_ready(players, game.max_players)) {
+		game.phase = ASSIGNING_WORDS;
+		broadcast_alert(players, "Début de la partie ! Attribution des mots...");
+		assign_words(players, &game);
+	}
+}
+
+// /top [N] : les N premiers du classement global
+static void handle_top(Player *p, const char *arg) {
+	static Leaderboard_Row rows[LEADERBOARD_MAX_TOP];
+
+	int n = arg ? atoi(arg) : LEADERBOARD_DEFAULT_TOP;
+	if (n < 1) n = LEADERBOARD_DEFAULT_TOP;
+	if (n > LEADERBOARD_MAX_TOP) n = LEADERBOARD_MAX_TOP;
+
+	size_t count = leaderboard_top(rows, n);
+
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "TOP");
+	msg_addf(&msg, "%zu", leaderboard_size());
+	for (size_t i = 0; i < count; i++) {
+		msg_add(&msg, rows[i].username);
+		msg_addi(&msg, rows[i].score);
+	}
+	send_msg(p, &msg);
+	msg_free(&msg);
+}
+
+// /rank [nom] : rang d'un joueur (soi-même par défaut)
+static void handle_rank(Player *p, const char *arg) {
+	const char *username = arg ? arg : p->username;
+	int score = 0;
+	size_t rank = leaderboard_rank(username, &score);
+	if (!rank) {
+		send_ret(p, "RANK", "106");
+		return;
+	}
+
+	Message msg;
+	msg_init(&msg, MSG_INFO);
+	msg_add(&msg, "RANK");
+	msg_add(&msg, username);
+	msg_addf(&msg, "%zu", rank);
+	msg_addi(&msg, score);
+	msg_addf(&msg, "%zu", leaderboard_size());
+	send_msg(p, &msg);
+	msg_free(&msg);
+}
+
+// /ping T : renvoie T avec l'heure du serveur, le client en déduit son aller-retour et son décalage
+static void handle_ping(Player *p, const char *arg) {
+	p->pings = true;
+
+	Message msg;
+	msg_init(&msg, MSG_PONG);
+	msg_add(&msg, arg);
+	msg_addf(&msg, "%llu", (unsigned long long)clock_ms());
+	send_msg(p, &msg);
+	msg_free(&msg);
+}
+
+// /pong T : réponse à un de nos /ping, T est l'heure de son envoi
+static void handle_pong(Player *p, const char *arg) {
+	char *end;
+	unsigned long long sent = strtoull(arg, &end, 10);
+	uint64_t now = clock_ms();
+	if (*end != '\0' || sent > now || now - sent > RTT_MAX_SAMPLE_MS) return;
+
+	rtt_add_sample(&p->rtt, (uint32_t)(now - sent));
+	if (debug) {
+		printf("RTT %s@%s : %u ms (lissé %u ms, min %u ms)\n", p->username[0] ? p->username : "Unknown", p->addr,
+			p->rtt.last, p->rtt.srtt, p->rtt.min);
+	}
+}
+
+// Les clients qui ont envoyé un /ping reçoivent les nôtres toutes les PING_INTERVAL_MS
+static void send_pings(Player *players) {
+	uint64_t now = clock_ms();
+	for (Player *p = players; p; p = p->next) {
+		if (!p->pings || now - p->last_ping < PING_INTERVAL_MS) continue;
+		p->last_ping = now;
+
+		Message msg;
+		msg_init(&msg, MSG_PING);
+		msg_addf(&msg, "%llu", (unsigned long long)now);
+		send_msg(p, &msg);
+		msg_free(&msg);
+	}
+}
+
+// /ping et /pong reviennent sans cesse : ils ne sont pas journalisés
+static bool is_heartbeat(const char *line) {
+	return strncmp(line, "/p", 2) == 0 && (strncmp(line + 2, "ing", 3) == 0 || strncmp(line + 2, "ong", 3) == 0)
+		&& (line[5] == '\0' || line[5] == ' ');
+}
+
+// Traitement optimisé des commandes avec comparaison sur le deuxième caractère
+static void handle_command(Player *p, Command *command_parsed) {
+	if (!command_parsed) {
+		send_ret(p, "PROTO", "201");
+		return;
+	}
+
+	if (debug) {
+		print_command(command_parsed);
+	}
+
+	const char *cmd = command_parsed->command;
+	const char *arg = command_parsed->param_count > 0 ? command_parsed->params[0] : NULL;
+	
+	if (cmd[1] == 'l' && strcmp(cmd, "/login") == 0) {
+		handle_login(p, arg);
+	} else if (cmd[1] == 'p' && strcmp(cmd, "/play") == 0 && arg) {
+		if (game.phase == PLAYING) {
+			handle_word_submission(players, &game, p, arg);
+		} else {
+			send_ret(p, "PLAY", "202");
+		}
+	} else if (cmd[1] == 'c' && strcmp(cmd, "/choice") == 0 && arg) {
+		if (game.phase == VOTING) {
+			handle_vote(players, &game, p, arg);
+		} else {
+			send_ret(p, "CHOICE", "202");
+		}
+	} else if (cmd[1] == 'p' && strcmp(cmd, "/proto") == 0 && arg && strcasecmp(arg, "BIN") == 0) {
+		// L'acquittement part encore dans l'encodage courant, la suite est binaire
+		send_ret(p, "PROTO", "000");
+		p->binary = true;
+	} else if (cmd[1] == 'p' && strcmp(cmd, "/proto") == 0 && arg && strcasecmp(arg, "ID") == 0) {
+		send_ret(p, "PROTO", "000");
+		p->ids = true;
+		send_roster(p);
+	} else if (cmd[1] == 'p' && strcmp(cmd, "/ping") == 0) {
+		handle_ping(p, arg);
+	} else if (cmd[1] == 'p' && strcmp(cmd, "/pong") == 0 && arg) {
+		handle_pong(p, arg);
+	} else if (cmd[1] == 't' && strcmp(cmd, "/top") == 0) {
+		handle_top(p, arg);
+	} else if (cmd[1] == 'r' && strcmp(cmd, "/rank") == 0) {
+		handle_rank(p, arg);
+	} else {
+		send_ret(p, "PROTO", "201");
+	}
+}
+
+/*
+ * Découpe le tampon d'entrée d'un client en commandes : lignes terminées par '\n'
+ * en protocole texte, trames préfixées par leur taille en binaire.
+ * Retourne false si la connexion doit être fermée (trame invalide, ligne trop longue).
+ */
+static bool process_input(Player *p) {
+	// Palier « retard » du limiteur : les commandes attendent, dans une limite de taille
+	if (p->rate.paused_until) {
+		if (clock_ms() < p->rate.paused_until) return p->in.len <= RATE_MAX_PENDING;
+		p->rate.paused_until = 0;
+	}
+
+	while (p->in.len > 0) {
+		Command *command_parsed = NULL;
+		const char *name = p->username[0] ? p->username : ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown" ANSI_RESET_ALL;
+		enum rate_verdict verdict;
+
+		if (p->binary) {
+			int consumed = proto_decode_frame((const uint8_t *)p->in.data, p->in.len, &command_parsed);
+			if (consumed < 0) return false;
+			if (consumed == 0) break;
+
+			buffer_consume(&p->in, consumed);
+			verdict = rate_check(&p->rate, command_parsed->command, clock_ms());
+			if (verdict == RATE_OK && !is_heartbeat(command_parsed->command)) log_message(name, command_parsed->command, p->addr);
+		} else {
+			char *newline = memchr(p->in.data, '\n', p->in.len);
+			if (!newline) {
+				if (p->in.len > PROTO_MAX_LINE) return false;
+				break;
+			}
+
+			// Nettoyage optimisé de la ligne
+			size_t line_len = newline - p->in.data;
+			*newline = '\0';
+			char *end = newline - 1;
+			while (end >= p->in.data && *end == '\r') {
+				*end-- = '\0';
+			}
+
+			if (p->in.data[0] == '\0') {
+				buffer_consume(&p->in, line_len + 1);
+				continue;
+			}
+
+			command_parsed = parse_input(p->in.data);
+			verdict = rate_check(&p->rate, command_parsed ? command_parsed->command : NULL, clock_ms());
+			if (verdict == RATE_OK && !is_heartbeat(p->in.data)) log_message(name, p->in.data, p->addr);
+			buffer_consume(&p->in, line_len + 1);
+		}
+
+		// Commande en trop : ni réponse ni journal, seuls les paliers sont signalés
+		if (verdict != RATE_OK) {
+			free_command(command_parsed);
+			if (verdict == RATE_DROP) continue;
+
+			char log[BUFFER_SIZE];
+			if (verdict == RATE_KICK) {
+				snprintf(log, sizeof(log), "Flood: disconnected after %u dropped commands", p->rate.strikes);
+				log_message(name, log, p->addr);
+				send_alert(p, "Trop de commandes, déconnexion.");
+				return false;
+			}
+			snprintf(log, sizeof(log), "Flood: input paused for %llu ms", (unsigned long long)(p->rate.paused_until - clock_ms()));
+			log_message(name, log, p->addr);
+			break;
+		}
+
+		p->last_activity = clock_ms();
+		handle_command(p, command_parsed);
+		free_command(command_parsed);
+	}
+	return true;
+}
+
+// Données reçues d'un client : décapsulation WebSocket éventuelle puis commandes
+static bool handle_incoming(Player *p, const char *data, int len) {
+	if (p->transport == TRANSPORT_WS) {
+		if (!buffer_append(&p->raw, data, len)) return false;
+
+		enum ws_status status = ws_process(p);
+		if (status == WS_ERROR) return false;
+		if (status == WS_OPENED) {
+			log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown", "WebSocket open, waiting for username.", p->addr);
+			send_greeting(p);
 		}
+	} else if (!buffer_append(&p->in, data, len)) {
+		return false;
+	}
+
+	return process_input(p);
+}
+
+// POLLOUT seulement pour les connexions qui ont des données en attente
+static void update_poll_events(int nfds) {
+	for (int i = listen_count; i < nfds; i++) {
+		Player *p = get_player_by_fd(players, pollfds[i].fd);
+		// Connexion suspendue par le limiteur : le noyau garde ses données (et freine l'émetteur)
+		pollfds[i].events = (p && p->rate.paused_until ? 0 : POLLIN) | (p && (p->out.len > 0 || p->tls_want_write) ? POLLOUT : 0);
 	}
 }
 
+static Player *uring_accepted(int client_fd, enum transport transport) {
+	struct sockaddr_in client_addr = {0};
+	socklen_t client_len = sizeof(client_addr);
+	getpeername(client_fd, (struct sockaddr*)&client_addr, &client_len);
+	return register_client(client_fd, transport, &client_addr);
+}
+
+static void uring_received(Player *p, const char *data, size_t len) {
+	if (!handle_incoming(p, data, len)) drop_player(p);
+}
+
+static const Uring_Handlers uring_handlers = {
+	.accepted = uring_accepted,
+	.received = uring_received,
+	.closed = drop_player,
+	.shed = shed_connection,
+};
+
+// Fermeture à l'initiative du serveur, quel que soit le moteur d'E/S
+static void evict_player(Player *p, int *nfds, const char *reason) {
+	if (reason) send_alert(p, reason);
+
+	if (uring_enabled()) {
+		drop_player(p);
+		return;
+	}
+	for (int i = listen_count; i < *nfds; i++) {
+		if (pollfds[i].fd == p->fd) {
+			disconnect_client(i, nfds);
+			return;
+		}
+	}
+}
+
+// Libère les places tenues par des connexions qui ne s'identifient pas ou ne disent plus rien
+static void reap_connections(int *nfds) {
+	static uint64_t next_reap = 0;
+	uint64_t now = clock_ms();
+	if (now < next_reap) return;
+	next_reap = now + 1000;
+
+	Player *p = players;
+	while (p) {
+		Player *next = p->next;
+		char log[BUFFER_SIZE];
+
+		if (!p->username_set && now - p->connected_at >= LOGIN_TIMEOUT * 1000ULL) {
+			evictions.login++;
+			snprintf(log, sizeof(log), "Evicted: no login after %d s (%lu so far)", LOGIN_TIMEOUT, evictions.login);
+			log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown" ANSI_RESET_ALL, log, p->addr);
+			evict_player(p, nfds, "Délai d'identification dépassé.");
+		} else if (p->username_set && (p->pings || p->secret_word[0])
+				&& now - p->last_activity >= IDLE_TIMEOUT * 1000ULL) {
+			// En partie ou avec /ping seulement : un client sans /ping se tait légitimement dans le salon
+			evictions.idle++;
+			snprintf(log, sizeof(log), "Evicted: idle for %d s (%lu so far)", IDLE_TIMEOUT, evictions.idle);
+			log_message(p->username, log, p->addr);
+			evict_player(p, nfds, "Déconnecté pour inactivité.");
+		}
+		p = next;
+	}
+}
+
+// Fin d'une suspension du limiteur : les commandes restées en attente sont traitées
+static void resume_paused_input(int *nfds) {
+	uint64_t now = clock_ms();
+	Player *p = players;
+	while (p) {
+		Player *next = p->next;
+		if (p->rate.paused_until && now >= p->rate.paused_until && !process_input(p)) {
+			evict_player(p, nfds, NULL);
+		}
+		p = next;
+	}
+}
+
+// Attente de la boucle, bornée par l'échéance de la phase : fin de tour ou de vote sans retard
+static int loop_timeout(void) {
+	if (game.phase != PLAYING && game.phase != VOTING && game.phase != RESULTS) return 500;
+	uint64_t now = clock_ms();
+	if (now >= game.phase_deadline) return 0;
+	uint64_t left = game.phase_deadline - now;
+	return left < 500 ? (int)left : 500;
+}
+
+// Phases de jeu, à chaque tour de boucle quel que soit le moteur d'E/S
+static void tick_game(void) {
+	send_pings(players);
+
+	switch (game.phase) {
+		case PLAYING:
+			handle_playing_phase(players, &game);
+			break;
+		case VOTING:
+			handle_voting_phase(players, &game);
+			break;
+		case RESULTS:
+			handle_results_phase(players, &game);
+			break;
+		default:
+			break;
+	}
+}
+
+// defer : le client parle le premier (requête HTTP, ClientHello TLS), le noyau ne
+// réveille accept() qu'à l'arrivée de ses premiers octets
+static int create_listener(int port, bool defer) {
+	struct sockaddr_in addr;
+	int fd;
+
+	// Création et configuration du socket (non bloquant : accept4 vide le backlog jusqu'à EAGAIN)
+	if ((fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+		perror("socket");
+		exit(EXIT_FAILURE);
+	}
+
+	// Optimisation: réutilisation d'adresse
+	int reuse = 1;
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+		perror("setsockopt");
+	}
+
+	// En clair sur le port TCP, c'est le serveur qui parle le premier (/info ID) : pas de report
+	int defer_seconds = DEFER_ACCEPT_SECONDS;
+	if (defer && setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer_seconds, sizeof(defer_seconds)) < 0) {
+		perror("setsockopt TCP_DEFER_ACCEPT");
+	}
+
+	// Configuration de l'adresse
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = INADDR_ANY;
+	addr.sin_port = htons(port);
+
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		perror(ANSI_COLOR_RED ANSI_STYLE_BOLD "Bind " ANSI_RESET_ALL);
+		exit(EXIT_FAILURE);
+	}
+
+	if (listen(fd, SOMAXCONN) < 0) {
+		perror("listen");
+		exit(EXIT_FAILURE);
+	}
+
+	return fd;
+}
+
+static void load_leaderboard_entry(const char *username, int score, int games, void *ctx) {
+	leaderboard_update(username, score);
+}
+
 int main(int argc, char *argv[]) {
 	srand(time(NULL));
-	int opt, nfds = 1, port = DEFAULT_PORT;
-	struct sockaddr_in addr;
-	bool debug = false;
+	int opt, nfds, port = DEFAULT_PORT, ws_port = 0;
+	bool use_uring = false;
+	const char *tls_cert = NULL, *tls_key = NULL;
+	const char *store_dir = DEFAULT_STORE_DIR;
 
 	// Installation du handler de signal pour cleanup
 	signal(SIGINT, cleanup_handler);
 	signal(SIGTERM, cleanup_handler);
+	signal(SIGPIPE, SIG_IGN); // OpenSSL écrit directement sur la socket, sans MSG_NOSIGNAL
 
 	// Initialisation optimisée de la structure du jeu
 	game = (Game_State){
@@ -258,21 +905,25 @@ int main(int argc, char *argv[]) {
 		.max_rounds = DEFAULT_MAX_ROUNDS,
 		.timing_play = DEFAULT_TIMING_PLAY,
 		.timing_choice = DEFAULT_TIMING_CHOICE,
+		.simultaneous = false,
+		.vote_grace = DEFAULT_VOTE_GRACE,
 		.phase = WAITING,
 		.player_count = 0,
 		.impostor_idx = -1,
 		.current_turn = 0,
 		.current_round = 1,
 		.votes_received = 0,
-		.phase_start_time = 0,
+		.votes_complete = false,
+		.phase_deadline = 0,
 		.temps_restant = 0,
 		.played_words = NULL,
+		.arena = {0},
 		.common_word = {0},
 		.impostor_word = {0}
 	};
 
 	// Parsing des arguments optimisé avec validation anticipée
-	while ((opt = getopt(argc, argv, "p:j:r:t:T:d")) != -1) {
+	while ((opt = getopt(argc, argv, "p:w:c:k:s:j:l:q:r:t:T:g:mdu")) != -1) {
 		switch (opt) {
 			case 'p':
 				port = atoi(optarg);
@@ -281,12 +932,42 @@ int main(int argc, char *argv[]) {
 					exit(EXIT_FAILURE);
 				}
 				break;
+			case 'w':
+				ws_port = atoi(optarg);
+				if (ws_port <= 0 || ws_port > 65535) {
+					fprintf(stderr, "Erreur : le port WebSocket %s n'est pas valide (doit être entre 1 et 65535)\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'c':
+				tls_cert = optarg;
+				break;
+			case 'k':
+				tls_key = optarg;
+				break;
+			case 's':
+				store_dir = optarg;
+				break;
 			case 'j':
 				game.max_players = atoi(optarg);
-				if (game.max_players < MIN_PLAYERS) {
-					fprintf(stderr, "Erreur : le nombre maximal de joueurs doit être au moins %d\n", MIN_PLAYERS);
+				if (game.max_players < MIN_PLAYERS || game.max_players > MAX_ROOM_PLAYERS) {
+					fprintf(stderr, "Erreur : le nombre maximal de joueurs doit être compris entre %d et %d\n", MIN_PLAYERS, MAX_ROOM_PLAYERS);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'l':
+				max_per_ip = atoi(optarg);
+				if (max_per_ip < 0) {
+					fprintf(stderr, "Erreur : le nombre de connexions par IP doit être positif (0 : sans limite)\n");
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'q':
+				if (atoi(optarg) < 0) {
+					fprintf(stderr, "Erreur : le nombre de commandes par seconde doit être positif (0 : sans limite)\n");
 					exit(EXIT_FAILURE);
 				}
+				rate_configure(atoi(optarg));
 				break;
 			case 'r':
 				game.max_rounds = atoi(optarg);
@@ -309,11 +990,24 @@ int main(int argc, char *argv[]) {
 					exit(EXIT_FAILURE);
 				}
 				break;
+			case 'g':
+				game.vote_grace = atoi(optarg);
+				if (game.vote_grace < 0) {
+					fprintf(stderr, "Erreur : le délai de grâce du vote doit être positif ou nul\n");
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'm':
+				game.simultaneous = true;
+				break;
 			case 'd':
 				debug = true;
 				break;
+			case 'u':
+				use_uring = true;
+				break;
 			default:
-				fprintf(stderr, "Usage: %s [-p port] [-j max_players] [-r max_rounds] [-t TIMING_PLAY] [-T TIMING_CHOICE] [-d]\n", argv[0]);
+				fprintf(stderr, "Usage: %s [-p port] [-w ws_port] [-c cert.pem -k key.pem] [-s store_dir] [-j max_players] [-l max_per_ip] [-q cmds_per_second] [-r max_rounds] [-t TIMING_PLAY] [-T TIMING_CHOICE] [-g VOTE_GRACE] [-m] [-d] [-u]\n", argv[0]);
 				exit(EXIT_FAILURE);
 		}
 	}
@@ -329,202 +1023,182 @@ int main(int argc, char *argv[]) {
 	printf(ANSI_COLOR_YELLOW "● Nombre de joueurs    " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%d\n" ANSI_RESET_ALL, game.max_players);
 	printf(ANSI_COLOR_YELLOW "● Nombre de rounds     " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%d\n" ANSI_RESET_ALL, game.max_rounds);
 	printf(ANSI_COLOR_YELLOW "● TIMING_PLAY (sec)    " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%d\n" ANSI_RESET_ALL, game.timing_play);
-	printf(ANSI_COLOR_YELLOW "● TIMING_CHOICE (sec)  " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%d\n\n" ANSI_RESET_ALL, game.timing_choice);
+	printf(ANSI_COLOR_YELLOW "● TIMING_CHOICE (sec)  " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%d\n" ANSI_RESET_ALL, game.timing_choice);
+	printf(ANSI_COLOR_YELLOW "● VOTE_GRACE (sec)     " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%d\n" ANSI_RESET_ALL, game.vote_grace);
+	printf(ANSI_COLOR_YELLOW "● Mode de jeu          " ANSI_COLOR_WHITE "▸ " ANSI_STYLE_BOLD ANSI_COLOR_GREEN "%s\n\n" ANSI_RESET_ALL, game.simultaneous ? "simultané" : "tour par tour");
 
-	// Allocation optimisée avec vérification d'erreur
-	pollfds = calloc(game.max_players + 1, sizeof(struct pollfd));
-	if (!pollfds) {
-		perror("calloc pollfds");
-		exit(EXIT_FAILURE);
-	}
+	if (ws_port) listen_count = 2;
 
-	// Création et configuration du socket
-	if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-		perror("socket");
+	if (!store_open(store_dir)) {
+		fprintf(stderr, "Erreur : impossible d'ouvrir l'historique dans %s\n", store_dir);
 		exit(EXIT_FAILURE);
 	}
+	store_foreach(load_leaderboard_entry, NULL);
 
-	// Optimisation: réutilisation d'adresse
-	int reuse = 1;
-	if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
-		perror("setsockopt");
+	if (tls_cert || tls_key) {
+		if (!tls_cert || !tls_key || !tls_init(tls_cert, tls_key)) {
+			fprintf(stderr, "Erreur : impossible d'activer TLS (il faut -c CERTIFICAT et -k CLE valides)\n");
+			exit(EXIT_FAILURE);
+		}
+		printf(ANSI_COLOR_GREEN "TLS activé sur toutes les connexions (reprise de session par tickets)" ANSI_RESET_ALL "\n");
 	}
 
-	// Configuration de l'adresse
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_addr.s_addr = INADDR_ANY;
-	addr.sin_port = htons(port);
+	spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
 
-	if (bind(server_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-		perror(ANSI_COLOR_RED ANSI_STYLE_BOLD "Bind " ANSI_RESET_ALL);
+	// Allocation optimisée avec vérification d'erreur
+	pollfds = calloc(game.max_players + listen_count, sizeof(struct pollfd));
+	if (!pollfds) {
+		perror("calloc pollfds");
 		exit(EXIT_FAILURE);
 	}
-
-	if (listen(server_fd, SOMAXCONN) < 0) {
-		perror("listen");
+	if (!tally_init(&game.tally, game.max_players)) {
+		perror("calloc tally");
+		exit(EXIT_FAILURE);
+	}
+	game.roster = calloc(game.max_players, sizeof(Player *));
+	if (!game.roster) {
+		perror("calloc roster");
 		exit(EXIT_FAILURE);
 	}
 
+	server_fd = create_listener(port, tls_enabled());
 	pollfds[0].fd = server_fd;
 	pollfds[0].events = POLLIN;
-	printf(ANSI_COLOR_GREEN "Serveur en attente de connexion sur le port " ANSI_STYLE_BOLD "%d" ANSI_RESET_ALL "\n\n", port);
+	printf(ANSI_COLOR_GREEN "Serveur en attente de connexion sur le port " ANSI_STYLE_BOLD "%d" ANSI_RESET_ALL "\n", port);
+
+	if (ws_port) {
+		ws_fd = create_listener(ws_port, true);
+		pollfds[1].fd = ws_fd;
+		pollfds[1].events = POLLIN;
+		printf(ANSI_COLOR_GREEN "Passerelle WebSocket en écoute sur le port " ANSI_STYLE_BOLD "%d" ANSI_RESET_ALL "\n", ws_port);
+	}
+	printf("\n");
+	nfds = listen_count;
+
+	if (use_uring) {
+		if (tls_enabled()) {
+			printf(ANSI_COLOR_YELLOW "io_uring ignoré avec TLS : boucle poll()" ANSI_RESET_ALL "\n");
+		} else if (uring_init()) {
+			uring_listen(server_fd, TRANSPORT_TCP);
+			if (ws_fd >= 0) uring_listen(ws_fd, TRANSPORT_WS);
+			printf(ANSI_COLOR_GREEN "Moteur d'E/S io_uring (accept et recv multishot, envois groupés)" ANSI_RESET_ALL "\n");
+		} else {
+			printf(ANSI_COLOR_YELLOW "io_uring indisponible : boucle poll()" ANSI_RESET_ALL "\n");
+		}
+		printf("\n");
+	}
 
 	// Boucle principale optimisée
-	while (1) {
-		int poll_result = poll(pollfds, nfds, 500);
+	while (!stop_requested) {
+		if (uring_enabled()) {
+			int result = uring_wait(loop_timeout(), &uring_handlers);
+			if (result < 0) {
+				fprintf(stderr, ANSI_COLOR_RED "io_uring_enter failed: %s" ANSI_RESET_ALL "\n", strerror(-result));
+				break;
+			}
+			tick_game();
+			reap_connections(NULL);
+			resume_paused_input(NULL);
+			continue;
+		}
+
+		update_poll_events(nfds);
+		int poll_result = poll(pollfds, nfds, loop_timeout());
 		if (poll_result < 0) {
 			if (errno == EINTR) continue; // Signal interrompu, continuer
 			perror(ANSI_COLOR_RED "Poll failed " ANSI_RESET_ALL);
 			break;
 		}
 
+		// Tout ce que ce tour produit part en fin de tour, un send() par joueur (io_uring regroupe déjà ses envois)
+		player_cork();
+
 		// Gestion des nouvelles connexions
 		if (pollfds[0].revents & POLLIN) {
-			handle_new_connection(server_fd, pollfds, &nfds, &players, &game);
+			handle_new_connections(server_fd, TRANSPORT_TCP, &nfds);
+		}
+		if (ws_fd >= 0 && pollfds[1].revents & POLLIN) {
+			handle_new_connections(ws_fd, TRANSPORT_WS, &nfds);
 		}
 
 		// Gestion des phases de jeu
-		switch (game.phase) {
-			case PLAYING:
-				handle_playing_phase(players, &game);
-				break;
-			case VOTING:
-				handle_voting_phase(players, &game);
-				break;
-			default:
-				break;
-		}
+		tick_game();
+		reap_connections(&nfds);
+		resume_paused_input(&nfds);
 
 		// Traitement optimisé des messages clients
-		for (int i = 1; i < nfds; i++) {
-			if (!(pollfds[i].revents & (POLLIN | POLLERR | POLLHUP))) continue;
+		for (int i = listen_count; i < nfds; i++) {
+			short revents = pollfds[i].revents;
+			if (!revents) continue;
 
 			int client_fd = pollfds[i].fd;
 			Player *p = get_player_by_fd(players, client_fd);
 			if (!p) continue;
 
-			char buffer[BUFFER_SIZE];
-			int bytes_received = recv(client_fd, buffer, BUFFER_SIZE - 1, 0);
-
-			if (bytes_received <= 0) {
-				// Déconnexion client
-				log_message(p->username[0] ? p->username : ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown" ANSI_RESET_ALL, 
-						ANSI_COLOR_RED ANSI_STYLE_BOLD "Disconnected" ANSI_RESET_ALL, p->addr);
-				
-				snprintf(msg_buffer, BUFFER_SIZE, "/info ALERT:%s s'est déconnecté.\n", 
-						p->username[0] ? p->username : "Unknown");
-				
-				remove_player(&players, client_fd, &game);
-				pollfds[i] = pollfds[nfds - 1];
-				nfds--;
-				game.player_count--;
-
-				broadcast_message(players, msg_buffer, NULL);
-				
-				if (game.phase != WAITING && game.player_count < MIN_PLAYERS) {
-					broadcast_message(players, "/info ALERT:Un joueur s'est déconnecté. Le jeu a été interrompu. En attente d'autres joueurs...\n", NULL);
-					reset_game(&game, players);
-				}
-				i--; // Ajuster l'index après suppression
-				continue;
-			}
+			bool readable = revents & (POLLIN | POLLERR | POLLHUP);
 
-			// Nettoyage optimisé du buffer
-			buffer[bytes_received] = '\0';
-			char *end = buffer + bytes_received - 1;
-			while (end >= buffer && (*end == '\n' || *end == '\r')) {
-				*end-- = '\0';
+			if (p->ssl && !p->tls_ready) {
+				enum tls_status status = tls_handshake(p);
+				if (status == TLS_PENDING) continue;
+				if (status == TLS_ERROR) {
+					disconnect_client(i, &nfds);
+					i--;
+					continue;
+				}
+				if (p->transport == TRANSPORT_TCP) send_greeting(p);
+				readable = true; // OpenSSL a pu lire des données applicatives avec le handshake
 			}
 
-			log_message(p->username[0] ? p->username : ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown" ANSI_RESET_ALL, buffer, p->addr);
-
-			Command *command_parsed = parse_input(buffer);
-
-			if (debug && command_parsed) {
-				print_command(command_parsed);
+			if (revents & POLLOUT) {
+				player_flush(p);
 			}
+			if (!readable) continue;
 
-			if (!command_parsed) {
-				static const char proto_error[] = "/ret PROTO:201\n";
-				send(p->fd, proto_error, sizeof(proto_error) - 1, 0);
-				log_server_message(p->username, proto_error, p->addr);
-				continue;
-			}
+			// En TLS, on vide aussi ce qu'OpenSSL a déjà déchiffré
+			bool closed = false;
+			do {
+				char buffer[BUFFER_SIZE];
+				ssize_t bytes_received = player_recv(p, buffer, BUFFER_SIZE);
+				if (bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) break;
 
-			// Traitement optimisé des commandes avec switch sur hash ou comparaison optimisée
-			const char *cmd = command_parsed->command;
-			
-			if (cmd[1] == 'l' && strcmp(cmd, "/login") == 0) {
-				if (!p->username_set) {
-					const char *username = command_parsed->params[0];
-
-					// Validation optimisée
-					if (!username || strlen(username) < MIN_USERNAME || 
-						strchr(username, ':') != NULL || 
-						get_player_by_username(players, username)) {
-						
-						const char *error_msg = !username || strlen(username) < MIN_USERNAME || strchr(username, ':') != NULL ? "/ret LOGIN:107\n" : "/ret LOGIN:101\n";
-						send(p->fd, error_msg, strlen(error_msg), 0);
-						send(p->fd, "/login\n", 8, 0);
-						log_server_message(p->username, error_msg, p->addr);
-						free_command(command_parsed);
-						continue;
-					}
-
-					strncpy(p->username, username, MAX_USERNAME - 1);
-					p->username[MAX_USERNAME - 1] = '\0';
-					p->username_set = true;
-					p->ready = true;
-
-					static const char success_msg[] = "/ret LOGIN:000\n";
-					log_message(p->username, ANSI_COLOR_GREEN ANSI_STYLE_BOLD "Connected" ANSI_RESET_ALL, p->addr);
-					send(p->fd, success_msg, sizeof(success_msg) - 1, 0);
-					log_server_message(p->username, success_msg, p->addr);
-
-					snprintf(msg_buffer, BUFFER_SIZE, "/info LOGIN:%d/%d:%s\n", 
-					count_ready_players(players), game.max_players, username);
-					broadcast_message(players, msg_buffer, NULL);
-					
-					if (game.phase == WAITING && all_players_ready(players, game.max_players)) {
-						game.phase = ASSIGNING_WORDS;
-						broadcast_message(players, "/info ALERT:Début de la partie ! Attribution des mots...\n", NULL);
-						assign_words(players, &game);
-					}
-				} else {
-					static const char already_logged[] = "/ret LOGIN:202\n";
-					send(p->fd, already_logged, sizeof(already_logged) - 1, 0);
-					log_server_message(p->username, already_logged, p->addr);
+				if (bytes_received <= 0 || !handle_incoming(p, buffer, bytes_received)) {
+					closed = true;
 				}
-			} else if (cmd[1] == 'p' && strcmp(cmd, "/play") == 0) {
-				if (game.phase == PLAYING) {
-					handle_word_submission(players, &game, p, command_parsed->params[0]);
-				} else {
-					static const char play_error[] = "/ret PLAY:202\n";
-					send(p->fd, play_error, sizeof(play_error) - 1, 0);
-					log_server_message(p->username, play_error, p->addr);
-				}
-			} else if (cmd[1] == 'c' && strcmp(cmd, "/choice") == 0) {
-				if (game.phase == VOTING) {
-					handle_vote(players, &game, p, command_parsed->params[0]);
-				} else {
-					static const char choice_error[] = "/ret CHOICE:202\n";
-					send(p->fd, choice_error, sizeof(choice_error) - 1, 0);
-					log_server_message(p->username, choice_error, p->addr);
-				}
-			} else {
-				static const char proto_error[] = "/ret PROTO:201\n";
-				send(p->fd, proto_error, sizeof(proto_error) - 1, 0);
-				log_server_message(p->username, proto_error, p->addr);
+			} while (!closed && tls_pending(p));
+
+			if (closed) {
+				disconnect_client(i, &nfds);
+				i--; // Ajuster l'index après suppression
 			}
-			
-			free_command(command_parsed);
 		}
+
+		player_uncork(players);
 	}
 
 	// Nettoyage final
+	printf("\nArrêt du serveur...\n");
+	printf("Connexions expulsées : %lu sans identification, %lu inactives\n", evictions.login, evictions.idle);
+	const Rate_Stats *rate = rate_stats();
+	printf("Limiteur de commandes : %lu ignorées, %lu suspensions, %lu déconnexions\n", rate->dropped, rate->delayed, rate->kicked);
+	if (!uring_enabled()) {
+		const Send_Stats *sends = player_send_stats();
+		printf("Envois : %lu messages en %lu appels à send()\n", sends->messages, sends->writes);
+	}
+	store_close();
+	leaderboard_free();
+	const Slab_Pool *pool = player_pool_stats();
+	printf("Mémoire : %lu joueurs alloués (pic %zu simultanés, %zu blocs de %d), arène de partie %zu octets (pic %zu utilisés, %lu parties)\n",
+		pool->allocs, pool->peak, pool->slab_count, SLAB_OBJECTS, game.arena.capacity, game.arena.peak, game.arena.resets);
 	free_played_words(&game);
+	arena_free(&game.arena);
+	tally_free(&game.tally);
+	free(game.roster);
 	free(pollfds);
+	uring_cleanup();
+	if (spare_fd >= 0) close(spare_fd);
 	close(server_fd);
+	if (ws_fd >= 0) close(ws_fd);
+	free_all_players(&players);
+	tls_cleanup();
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include <time.h>
+
+#include "../include/latency.h"
+
+uint64_t clock_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void rtt_add_sample(Rtt_Stats *stats, uint32_t rtt) {
+	if (stats->samples == 0) {
+		stats->srtt = rtt;
+		stats->rttvar = rtt / 2;
+		stats->min = stats->max = rtt;
+	} else {
+		uint32_t delta = rtt > stats->srtt ? rtt - stats->srtt : stats->srtt - rtt;
+		stats->rttvar = (3 * stats->rttvar + delta) / 4;
+		stats->srtt = (7 * stats->srtt + rtt) / 8;
+		if (rtt < stats->min) stats->min = rtt;
+		if (rtt > stats->max) stats->max = rtt;
+	}
+	stats->last = rtt;
+	stats->samples++;
+}
@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+
+#include "../include/leaderboard.h"
+#include "../include/utils.h"
+
+typedef struct Rank_Node Rank_Node;
+
+// Lien vers le suivant d'un niveau, avec le nombre de positions enjambées
+typedef struct Rank_Link {
+	Rank_Node *next;
+	size_t span;
+} Rank_Link;
+
+struct Rank_Node {
+	char username[MAX_USERNAME];
+	int score;
+	int level;
+	Rank_Node *hash_next;
+	Rank_Link links[];
+};
+
+static struct {
+	Rank_Node *head;
+	int level;
+	size_t length;
+
+	// Accès direct par nom (clé sans casse), pour retrouver un nœud sans parcourir la liste
+	Rank_Node **buckets;
+	size_t bucket_count;
+} board = { .level = 1 };
+
+// Ordre du classement : score décroissant, puis nom
+static int compare(const Rank_Node *node, int score, const char *username) {
+	if (node->score != score) return node->score > score ? -1 : 1;
+	return strcasecmp(node->username, username);
+}
+
+static int random_level(void) {
+	int level = 1;
+	while (level < LEADERBOARD_MAX_LEVEL && (rand() & 3) == 0) level++;
+	return level;
+}
+
+static Rank_Node *new_node(int level) {
+	Rank_Node *node = calloc(1, sizeof(Rank_Node) + level * sizeof(Rank_Link));
+	if (node) node->level = level;
+	return node;
+}
+
+static bool ensure_head(void) {
+	if (!board.head) board.head = new_node(LEADERBOARD_MAX_LEVEL);
+	return board.head != NULL;
+}
+
+static Rank_Node *find_node(const char *username) {
+	if (!board.bucket_count) return NULL;
+	Rank_Node *node = board.buckets[hash_username(username) % board.bucket_count];
+	while (node && strcasecmp(node->username, username) != 0) node = node->hash_next;
+	return node;
+}
+
+static void rehash(size_t new_count) {
+	Rank_Node **buckets = calloc(new_count, sizeof(Rank_Node *));
+	if (!buckets) return;
+
+	for (size_t i = 0; i < board.bucket_count; i++) {
+		Rank_Node *node = board.buckets[i];
+		while (node) {
+			Rank_Node *next = node->hash_next;
+			size_t b = hash_username(node->username) % new_count;
+			node->hash_next = buckets[b];
+			buckets[b] = node;
+			node = next;
+		}
+	}
+
+	free(board.buckets);
+	board.buckets = buckets;
+	board.bucket_count = new_count;
+}
+
+// Insère un nœud (niveau déjà tiré) à sa place selon son score
+static void link_node(Rank_Node *node) {
+	Rank_Node *update[LEADERBOARD_MAX_LEVEL];
+	size_t rank[LEADERBOARD_MAX_LEVEL];
+	Rank_Node *x = board.head;
+
+	for (int i = board.level - 1; i >= 0; i--) {
+		rank[i] = i == board.level - 1 ? 0 : rank[i + 1];
+		while (x->links[i].next && compare(x->links[i].next, node->score, node->username) < 0) {
+			rank[i] += x->links[i].span;
+			x = x->links[i].next;
+		}
+		update[i] = x;
+	}
+
+	if (node->level > board.level) {
+		for (int i = board.level; i < node->level; i++) {
+			rank[i] = 0;
+			update[i] = board.head;
+			board.head->links[i].span = board.length;
+		}
+		board.level = node->level;
+	}
+
+	for (int i = 0; i < node->level; i++) {
+		node->links[i].next = update[i]->links[i].next;
+		update[i]->links[i].next = node;
+		node->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+		update[i]->links[i].span = rank[0] - rank[i] + 1;
+	}
+	for (int i = node->level; i < board.level; i++) {
+		update[i]->links[i].span++;
+	}
+	board.length++;
+}
+
+static void unlink_node(Rank_Node *node) {
+	Rank_Node *update[LEADERBOARD_MAX_LEVEL];
+	Rank_Node *x = board.head;
+
+	for (int i = board.level - 1; i >= 0; i--) {
+		while (x->links[i].next && compare(x->links[i].next, node->score, node->username) < 0) {
+			x = x->links[i].next;
+		}
+		update[i] = x;
+	}
+
+	for (int i = 0; i < board.level; i++) {
+		if (update[i]->links[i].next == node) {
+			update[i]->links[i].span += node->links[i].span - 1;
+			update[i]->links[i].next = node->links[i].next;
+		} else {
+			update[i]->links[i].span--;
+		}
+	}
+	while (board.level > 1 && !board.head->links[board.level - 1].next) {
+		board.level--;
+	}
+	board.length--;
+}
+
+void leaderboard_update(const char *username, int score) {
+	if (!username || !username[0] || !ensure_head()) return;
+
+	Rank_Node *node = find_node(username);
+	if (node) {
+		if (node->score == score) return;
+		unlink_node(node);
+		node->score = score;
+		link_node(node);
+		return;
+	}
+
+	if (board.length >= board.bucket_count) {
+		rehash(board.bucket_count ? board.bucket_count * 2 : 64);
+		if (!board.bucket_count) return;
+	}
+
+	node = new_node(random_level());
+	if (!node) return;
+	strncpy(node->username, username, MAX_USERNAME - 1);
+	node->score = score;
+
+	size_t b = hash_username(username) % board.bucket_count;
+	node->hash_next = board.buckets[b];
+	board.buckets[b] = node;
+	link_node(node);
+}
+
+size_t leaderboard_rank(const char *username, int *score) {
+	Rank_Node *node = username ? find_node(username) : NULL;
+	if (!node) return 0;
+
+	// Descente en cumulant les positions enjambées jusqu'au nœud
+	size_t rank = 0;
+	Rank_Node *x = board.head;
+	for (int i = board.level - 1; i >= 0; i--) {
+		while (x->links[i].next && compare(x->links[i].next, node->score, node->username) <= 0) {
+			rank += x->links[i].span;
+			x = x->links[i].next;
+		}
+		if (x == node) break;
+	}
+
+	if (score) *score = node->score;
+	return rank;
+}
+
+size_t leaderboard_top(Leaderboard_Row *rows, size_t n) {
+	size_t count = 0;
+	for (Rank_Node *x = board.head ? board.head->links[0].next : NULL; x && count < n; x = x->links[0].next) {
+		rows[count].username = x->username;
+		rows[count].score = x->score;
+		count++;
+	}
+	return count;
+}
+
+size_t leaderboard_size(void) {
+	return board.length;
+}
+
+void leaderboard_free(void) {
+	Rank_Node *x = board.head ? board.head->links[0].next : NULL;
+	while (x) {
+		Rank_Node *next = x->links[0].next;
+		free(x);
+		x = next;
+	}
+	free(board.head);
+	free(board.buckets);
+	board.head = NULL;
+	board.buckets = NULL;
+	board.bucket_count = 0;
+	board.length = 0;
+	board.level = 1;
+}
@@ -2,27 +2,65 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
 
 #include "../include/game.h"
 #include "../include/player.h"
 #include "../include/utils.h"
+#include "../include/websocket.h"
+#include "../include/tls.h"
+#include "../include/uring.h"
+
+// Joueurs (connexions) recyclés sans malloc ; la taille d'un objet dépend du nombre de rounds
+static Slab_Pool player_pool;
+
+// Bouchon (façon TCP_CORK) : les messages s'accumulent dans out jusqu'à player_uncork()
+static bool corked = false;
+static Send_Stats send_stats;
 
 Player* add_player(Player **head, int fd, Game_State *game) {
-	Player *new_player = malloc(sizeof(Player));
+	if (!player_pool.object_size) {
+		pool_init(&player_pool, "joueurs", sizeof(Player) + game->max_rounds * MAX_WORD);
+	}
+	Player *new_player = pool_alloc(&player_pool);
 	if (!new_player) return NULL;
 
 	new_player->fd = fd;
+	new_player->ip = 0;
 	new_player->username[0] = '\0';
 	new_player->username_set = false;
 	new_player->secret_word[0] = '\0';
 	new_player->score = 0;
 	new_player->ready = false;
-	new_player->vote[0] = '\0';
+	new_player->id = -1;
+	new_player->vote = -1;
+	new_player->voted = false;
+	new_player->binary = false;
+	new_player->ids = false;
+	new_player->in = (Buffer){0};
+	new_player->out = (Buffer){0};
+	new_player->transport = TRANSPORT_TCP;
+	new_player->ws_open = false;
+	new_player->raw = (Buffer){0};
+	new_player->ssl = NULL;
+	new_player->tls_ready = false;
+	new_player->tls_want_write = false;
+	new_player->pings = false;
+	new_player->last_ping = 0;
+	new_player->connected_at = clock_ms();
+	new_player->last_activity = new_player->connected_at;
+	rate_init(&new_player->rate, new_player->connected_at);
+	new_player->rtt = (Rtt_Stats){0};
+	new_player->sending = (Buffer){0};
+	new_player->uring_ops = 0;
+	new_player->uring_dirty = false;
+	new_player->uring_closing = false;
+	new_player->flush_pending = false;
 	new_player->next = *head;
 
-	new_player->submitted_words = malloc(game->max_rounds * sizeof(char *));
+	new_player->submitted_words = (char (*)[MAX_WORD])(new_player + 1);
 	for (int i = 0; i < game->max_rounds; i++) {
-		new_player->submitted_words[i] = malloc(MAX_WORD * sizeof(char));
 		new_player->submitted_words[i][0] = '\0';
 	}
 
@@ -31,16 +69,23 @@ Player* add_player(Player **head, int fd, Game_State *game) {
 }
 
 void remove_player(Player **head, int fd, Game_State *game) {
+	Player *player = get_player_by_fd(*head, fd);
+	if (!player) return;
+	if (player->flush_pending) player_flush(player); // Dernier message (ALERT d'expulsion...) avant la fermeture
+	unlink_player(head, player);
+	free_player(player);
+}
+
+// Retire un joueur de la liste sans le libérer
+void unlink_player(Player **head, Player *player) {
 	Player *curr = *head, *prev = NULL;
 	while (curr) {
-		if (curr->fd == fd) {
+		if (curr == player) {
 			if (prev) {
 				prev->next = curr->next;
 			} else {
 				*head = curr->next;
 			}
-			close(curr->fd);
-			free(curr);
 			return;
 		}
 		prev = curr;
@@ -48,6 +93,30 @@ void remove_player(Player **head, int fd, Game_State *game) {
 	}
 }
 
+void free_player(Player *player) {
+	tls_detach(player);
+	close(player->fd);
+	buffer_free(&player->in);
+	buffer_free(&player->out);
+	buffer_free(&player->raw);
+	buffer_free(&player->sending);
+	pool_free(&player_pool, player);
+}
+
+// Arrêt du serveur : les joueurs restants puis les blocs du pool
+void free_all_players(Player **head) {
+	while (*head) {
+		Player *next = (*head)->next;
+		free_player(*head);
+		*head = next;
+	}
+	pool_destroy(&player_pool);
+}
+
+const Slab_Pool *player_pool_stats(void) {
+	return &player_pool;
+}
+
 Player* get_player_by_fd(Player *head, int fd) {
 	while (head) {
 		if (head->fd == fd) return head;
@@ -91,6 +160,15 @@ int count_players(Player *head) {
 	return count;
 }
 
+int count_players_from(Player *head, uint32_t ip) {
+	int count = 0;
+	while (head) {
+		if (head->ip == ip) count++;
+		head = head->next;
+	}
+	return count;
+}
+
 int count_ready_players(Player *head) {
 	int count = 0;
 	while (head) {
@@ -102,4 +180,78 @@ int count_ready_players(Player *head) {
 
 bool all_players_ready(Player *head, int ready_count) {
 	return count_ready_players(head) == ready_count;
-}
\ No newline at end of file
+}
+
+ssize_t player_recv(Player *player, void *buf, size_t len) {
+	if (player->ssl) return tls_read(player, buf, len);
+	return recv(player->fd, buf, len, 0);
+}
+
+// Envoie ce qui peut l'être sans bloquer, le reste attend POLLOUT
+void player_flush(Player *player) {
+	if (uring_enabled()) {
+		uring_send(player);
+		return;
+	}
+	if (player->ssl && !player->tls_ready) return;
+
+	while (player->out.len > 0) {
+		ssize_t sent = player->ssl
+			? tls_write(player, player->out.data, player->out.len)
+			: send(player->fd, player->out.data, player->out.len, MSG_NOSIGNAL | MSG_DONTWAIT);
+		send_stats.writes++;
+		if (sent < 0) {
+			if (errno == EINTR) continue;
+			// Erreur fatale : la déconnexion sera constatée par recv()
+			if (errno != EAGAIN && errno != EWOULDBLOCK) player->out.len = 0;
+			return;
+		}
+		buffer_consume(&player->out, sent);
+	}
+}
+
+static void flush_or_defer(Player *player) {
+	if (corked) {
+		player->flush_pending = true;
+	} else {
+		player_flush(player);
+	}
+}
+
+// Octets bruts ajoutés à la file de sortie (handshake HTTP, trames déjà formées)
+void player_write(Player *player, const void *data, size_t len) {
+	bool was_empty = player->out.len == 0;
+	buffer_append(&player->out, data, len);
+	if (was_empty) flush_or_defer(player);
+}
+
+// Message du protocole de jeu, encapsulé selon le transport de la connexion
+void player_send(Player *player, const void *data, size_t len) {
+	bool was_empty = player->out.len == 0;
+	if (player->transport == TRANSPORT_WS) {
+		if (!player->ws_open) return;
+		ws_encode_frame(&player->out, player->binary ? WS_OP_BINARY : WS_OP_TEXT, data, len);
+	} else {
+		buffer_append(&player->out, data, len);
+	}
+	send_stats.messages++;
+	if (was_empty) flush_or_defer(player);
+}
+
+void player_cork(void) {
+	corked = true;
+}
+
+// Fin du tour : un seul envoi par joueur pour tout ce qui s'est accumulé pendant le bouchon
+void player_uncork(Player *head) {
+	corked = false;
+	for (Player *p = head; p; p = p->next) {
+		if (!p->flush_pending) continue;
+		p->flush_pending = false;
+		player_flush(p);
+	}
+}
+
+const Send_Stats *player_send_stats(void) {
+	return &send_stats;
+}
@@ -0,0 +1,131 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "../include/pool.h"
+
+#define ALIGN(size) (((size) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+struct Slab {
+	Slab *next;
+	max_align_t objects[]; // SLAB_OBJECTS objets de object_size octets
+};
+
+struct Arena_Chunk {
+	Arena_Chunk *next;
+	size_t size;
+	size_t used;
+	max_align_t data[];
+};
+
+void pool_init(Slab_Pool *pool, const char *name, size_t object_size) {
+	*pool = (Slab_Pool){0};
+	pool->name = name;
+	// Un objet libre sert de maillon à la liste libre
+	pool->object_size = ALIGN(object_size < sizeof(void *) ? sizeof(void *) : object_size);
+}
+
+static bool grow(Slab_Pool *pool) {
+	Slab *slab = malloc(sizeof(Slab) + SLAB_OBJECTS * pool->object_size);
+	if (!slab) return false;
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	pool->slab_count++;
+
+	// Chaînage à l'envers : le premier objet du bloc sort en premier
+	char *base = (char *)slab->objects;
+	for (int i = SLAB_OBJECTS - 1; i >= 0; i--) {
+		void **object = (void **)(base + i * pool->object_size);
+		*object = pool->free_list;
+		pool->free_list = object;
+	}
+	return true;
+}
+
+void *pool_alloc(Slab_Pool *pool) {
+	if (!pool->free_list && !grow(pool)) return NULL;
+
+	void **object = pool->free_list;
+	pool->free_list = *object;
+	pool->in_use++;
+	pool->allocs++;
+	if (pool->in_use > pool->peak) pool->peak = pool->in_use;
+	return object;
+}
+
+void pool_free(Slab_Pool *pool, void *object) {
+	if (!object) return;
+	*(void **)object = pool->free_list;
+	pool->free_list = object;
+	pool->in_use--;
+}
+
+void pool_destroy(Slab_Pool *pool) {
+	Slab *slab = pool->slabs;
+	while (slab) {
+		Slab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+	pool->slabs = NULL;
+	pool->free_list = NULL;
+	pool->slab_count = 0;
+	pool->in_use = 0;
+}
+
+static Arena_Chunk *new_chunk(size_t size) {
+	Arena_Chunk *chunk = malloc(sizeof(Arena_Chunk) + size);
+	if (!chunk) return NULL;
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+	size = ALIGN(size);
+
+	Arena_Chunk *chunk = arena->chunks;
+	if (!chunk || chunk->size - chunk->used < size) {
+		chunk = new_chunk(size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE);
+		if (!chunk) return NULL;
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->capacity += chunk->size;
+	}
+
+	void *ptr = (char *)chunk->data + chunk->used;
+	chunk->used += size;
+	arena->used += size;
+	if (arena->used > arena->peak) arena->peak = arena->used;
+	return ptr;
+}
+
+void arena_reset(Arena *arena) {
+	arena->resets++;
+	arena->used = 0;
+	if (!arena->chunks) return;
+
+	// Plusieurs blocs : remplacés par un seul de la taille cumulée
+	if (arena->chunks->next) {
+		size_t capacity = arena->capacity;
+		arena_free(arena);
+		arena->chunks = new_chunk(capacity);
+		arena->capacity = arena->chunks ? capacity : 0;
+		return;
+	}
+	arena->chunks->used = 0;
+}
+
+void arena_free(Arena *arena) {
+	Arena_Chunk *chunk = arena->chunks;
+	while (chunk) {
+		Arena_Chunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	arena->chunks = NULL;
+	arena->capacity = 0;
+	arena->used = 0;
+}
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "../include/protocol.h"
+#include "../include/player.h"
+#include "../include/color.h"
+
+static const char *const msg_names[MSG_TYPE_COUNT] = {
+	[MSG_UNKNOWN] = "/unknown",
+	[MSG_LOGIN]   = "/login",
+	[MSG_PLAY]    = "/play",
+	[MSG_CHOICE]  = "/choice",
+	[MSG_ASSIGN]  = "/assign",
+	[MSG_INFO]    = "/info",
+	[MSG_RET]     = "/ret",
+	[MSG_PROTO]   = "/proto",
+	[MSG_TOP]     = "/top",
+	[MSG_RANK]    = "/rank",
+	[MSG_PING]    = "/ping",
+	[MSG_PONG]    = "/pong",
+};
+
+void msg_init(Message *msg, enum msg_type type) {
+	msg->type = type;
+	msg->field_count = 0;
+	msg->fields = (Buffer){0};
+}
+
+void msg_add(Message *msg, const char *field) {
+	if (!field) field = "";
+	if (buffer_append(&msg->fields, field, strlen(field) + 1)) {
+		msg->field_count++;
+	}
+}
+
+void msg_addf(Message *msg, const char *fmt, ...) {
+	char field[BUFFER_SIZE];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(field, sizeof(field), fmt, args);
+	va_end(args);
+	msg_add(msg, field);
+}
+
+void msg_addi(Message *msg, int value) {
+	msg_addf(msg, "%d", value);
+}
+
+void msg_free(Message *msg) {
+	buffer_free(&msg->fields);
+	msg->field_count = 0;
+}
+
+const char *msg_type_name(enum msg_type type) {
+	if (type <= MSG_UNKNOWN || type >= MSG_TYPE_COUNT) return msg_names[MSG_UNKNOWN];
+	return msg_names[type];
+}
+
+enum msg_type msg_type_from_name(const char *name) {
+	for (int t = MSG_UNKNOWN + 1; t < MSG_TYPE_COUNT; t++) {
+		if (strcmp(msg_names[t], name) == 0) return (enum msg_type)t;
+	}
+	return MSG_UNKNOWN;
+}
+
+// Copie un champ dans une ligne texte : ':' et les fins de ligne n'y ont pas leur place
+static void append_text_field(Buffer *out, const char *field) {
+	static const char fullwidth_colon[] = "\xEF\xBC\x9A";
+
+	for (const char *c = field; *c; c++) {
+		if (*c == ':') {
+			buffer_append(out, fullwidth_colon, sizeof(fullwidth_colon) - 1);
+		} else if (*c == '\n' || *c == '\r') {
+			buffer_append(out, " ", 1);
+		} else {
+			buffer_append(out, c, 1);
+		}
+	}
+}
+
+void msg_encode_text(const Message *msg, Buffer *out) {
+	const char *name = msg_type_name(msg->type);
+	buffer_append(out, name, strlen(name));
+
+	const char *field = msg->fields.data;
+	for (int i = 0; i < msg->field_count; i++) {
+		buffer_append(out, i == 0 ? " " : ":", 1);
+		append_text_field(out, field);
+		field += strlen(field) + 1;
+	}
+	buffer_append(out, "\n", 1);
+}
+
+size_t varint_encode(uint64_t value, uint8_t *out) {
+	size_t n = 0;
+	while (value >= 0x80) {
+		out[n++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[n++] = (uint8_t)value;
+	return n;
+}
+
+// Retourne le nombre d'octets lus, 0 si incomplet, -1 si invalide
+int varint_decode(const uint8_t *buf, size_t len, uint64_t *value) {
+	uint64_t result = 0;
+	for (size_t i = 0; i < len && i < 10; i++) {
+		result |= (uint64_t)(buf[i] & 0x7F) << (7 * i);
+		if (!(buf[i] & 0x80)) {
+			*value = result;
+			return (int)i + 1;
+		}
+	}
+	return len >= 10 ? -1 : 0;
+}
+
+// Pire /info RESULT : en-tête, puis par joueur un nom (MAX_USERNAME - 1) et "score+gain" (13 octets au plus),
+// chacun précédé de sa taille ; /info ROSTER (identifiant et nom) est plus court
+_Static_assert(16 + MAX_ROOM_PLAYERS * (1 + (MAX_USERNAME - 1) + 1 + 13) <= PROTO_MAX_FRAME,
+		"MAX_ROOM_PLAYERS : le message RESULT dépasserait une trame binaire");
+
+void msg_encode_binary(const Message *msg, Buffer *out) {
+	uint8_t varint[10];
+	size_t payload_len = 1 + varint_encode(msg->field_count, varint);
+
+	const char *field = msg->fields.data;
+	for (int i = 0; i < msg->field_count; i++) {
+		size_t field_len = strlen(field);
+		payload_len += varint_encode(field_len, varint) + field_len;
+		field += field_len + 1;
+	}
+
+	if (!buffer_reserve(out, payload_len + sizeof(varint))) return;
+
+	buffer_append(out, varint, varint_encode(payload_len, varint));
+	uint8_t type = (uint8_t)msg->type;
+	buffer_append(out, &type, 1);
+	buffer_append(out, varint, varint_encode(msg->field_count, varint));
+
+	field = msg->fields.data;
+	for (int i = 0; i < msg->field_count; i++) {
+		size_t field_len = strlen(field);
+		buffer_append(out, varint, varint_encode(field_len, varint));
+		buffer_append(out, field, field_len);
+		field += field_len + 1;
+	}
+}
+
+/*
+ * Décode une trame binaire en Command (même forme que parse_input()).
+ * Retourne le nombre d'octets consommés, 0 si la trame est incomplète, -1 si elle est invalide.
+ */
+int proto_decode_frame(const uint8_t *buf, size_t len, Command **out) {
+	uint64_t payload_len, field_count;
+	int n = varint_decode(buf, len, &payload_len);
+	if (n <= 0) return n;
+	if (payload_len == 0 || payload_len > PROTO_MAX_FRAME) return -1;
+	if (len - n < payload_len) return 0;
+
+	const uint8_t *p = buf + n, *end = p + payload_len;
+	uint8_t type = *p++;
+
+	int m = varint_decode(p, end - p, &field_count);
+	if (m <= 0) return -1;
+	p += m;
+
+	Command *cmd = calloc(1, sizeof(Command));
+	if (!cmd) return -1;
+	cmd->params = calloc(MAX_PARAMS, sizeof(char *));
+	cmd->command = strdup(msg_type_name(type < MSG_TYPE_COUNT ? (enum msg_type)type : MSG_UNKNOWN));
+	if (!cmd->params || !cmd->command) {
+		free_command(cmd);
+		return -1;
+	}
+
+	for (uint64_t i = 0; i < field_count; i++) {
+		uint64_t field_len;
+		m = varint_decode(p, end - p, &field_len);
+		if (m <= 0 || field_len > (uint64_t)(end - p - m)) {
+			free_command(cmd);
+			return -1;
+		}
+		p += m;
+
+		if (cmd->param_count < MAX_PARAMS) {
+			char *param = strndup((const char *)p, field_len);
+			if (!param) {
+				free_command(cmd);
+				return -1;
+			}
+			cmd->params[cmd->param_count++] = param;
+		}
+		p += field_len;
+	}
+
+	*out = cmd;
+	return n + (int)payload_len;
+}
+
+void send_msg(Player *player, const Message *msg) {
+	Buffer text = {0};
+	msg_encode_text(msg, &text);
+
+	if (player->binary) {
+		Buffer frame = {0};
+		msg_encode_binary(msg, &frame);
+		player_send(player, frame.data, frame.len);
+		buffer_free(&frame);
+	} else {
+		player_send(player, text.data, text.len);
+	}
+
+	buffer_append(&text, "", 1);
+	if (msg->type != MSG_PING && msg->type != MSG_PONG) {
+		log_server_message(player->username, text.data, player->addr);
+	}
+	buffer_free(&text);
+}
+
+// Chaque encodage n'est produit qu'une fois, au premier destinataire qui le demande
+static void broadcast_versions(Player *head, const Message *msg, const Message *id_msg, Player *ignored_player) {
+	Buffer text = {0}, frame = {0}, id_text = {0}, id_frame = {0};
+	msg_encode_text(msg, &text);
+
+	for (Player *curr = head; curr; curr = curr->next) {
+		if (curr == ignored_player) continue;
+
+		bool ids = id_msg && curr->ids;
+		const Message *version = ids ? id_msg : msg;
+		Buffer *out;
+		if (curr->binary) {
+			out = ids ? &id_frame : &frame;
+			if (!out->len) msg_encode_binary(version, out);
+		} else {
+			out = ids ? &id_text : &text;
+			if (!out->len) msg_encode_text(version, out);
+		}
+		player_send(curr, out->data, out->len);
+	}
+
+	time_t now = time(NULL);
+	char *time_str = ctime(&now);
+	time_str[strlen(time_str) - 1] = '\0';
+
+	buffer_append(&text, "", 1);
+	printf(ANSI_STYLE_BOLD ANSI_COLOR_GREEN "[%s] " ANSI_COLOR_CYAN "Server broadcast a message to everyone > " ANSI_RESET_ALL ANSI_COLOR_YELLOW "%s" ANSI_RESET_ALL, time_str, text.data);
+
+	buffer_free(&text);
+	buffer_free(&frame);
+	buffer_free(&id_text);
+	buffer_free(&id_frame);
+}
+
+void broadcast_msg(Player *head, const Message *msg, Player *ignored_player) {
+	broadcast_versions(head, msg, NULL, ignored_player);
+}
+
+// Les clients qui ont négocié les identifiants (/proto ID) reçoivent id_msg, les autres msg (journalisé)
+void broadcast_msg_ids(Player *head, const Message *msg, const Message *id_msg) {
+	broadcast_versions(head, msg, id_msg, NULL);
+}
+
+// "/ret VERB:CODE"
+void send_ret(Player *player, const char *verb, const char *code) {
+	Message msg;
+	msg_init(&msg, MSG_RET);
+	msg_add(&msg, verb);
+	msg_add(&msg, code);
+	send_msg(player, &msg);
+	msg_free(&msg);
+}
+
+// "/play N:ÉCHÉANCE" ou "/choice N:ÉCHÉANCE" (échéance dans l'horloge du serveur, cf. latency.h)
+void send_timer(Player *player, enum msg_type type, int seconds, uint64_t deadline) {
+	Message msg;
+	msg_init(&msg, type);
+	msg_addi(&msg, seconds);
+	msg_addf(&msg, "%llu", (unsigned long long)deadline);
+	send_msg(player, &msg);
+	msg_free(&msg);
+}
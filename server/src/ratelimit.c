@@ -0,0 +1,95 @@
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "../include/ratelimit.h"
+
+typedef struct Rate_Limit {
+	uint32_t rate;   // Jetons par seconde
+	uint32_t burst;  // Capacité du seau
+} Rate_Limit;
+
+static Rate_Limit conn_limit = { DEFAULT_RATE_PER_SECOND, 2 * DEFAULT_RATE_PER_SECOND };
+
+// Un tour de jeu n'appelle qu'un /play et un vote : au-delà, c'est du bruit (ou un /info CHOICE de plus pour toute la table)
+static const struct {
+	const char *verb;
+	Rate_Limit limit;
+} verb_limits[RATE_VERB_COUNT] = {
+	[RATE_LOGIN]  = { "/login",  { 1, 5 } },
+	[RATE_PLAY]   = { "/play",   { 2, 4 } },
+	[RATE_CHOICE] = { "/choice", { 1, 5 } },
+	[RATE_PROTO]  = { "/proto",  { 1, 3 } },
+	[RATE_PING]   = { "/ping",   { 2, 10 } },
+	[RATE_QUERY]  = { "/top",    { 2, 10 } },
+};
+
+static Rate_Stats stats;
+
+void rate_configure(uint32_t per_second) {
+	conn_limit.rate = per_second;
+	conn_limit.burst = 2 * per_second;
+}
+
+static void fill(Token_Bucket *bucket, const Rate_Limit *limit, uint64_t now) {
+	bucket->tokens = limit->burst * 1000;
+	bucket->last = now;
+}
+
+void rate_init(Rate_State *state, uint64_t now) {
+	memset(state, 0, sizeof(*state));
+	fill(&state->conn, &conn_limit, now);
+	for (int i = 0; i < RATE_VERB_COUNT; i++) fill(&state->verbs[i], &verb_limits[i].limit, now);
+}
+
+// Remplissage paresseux (rate jetons/s = rate millièmes/ms) puis retrait d'un jeton
+static bool take(Token_Bucket *bucket, const Rate_Limit *limit, uint64_t now) {
+	uint64_t cap = (uint64_t)limit->burst * 1000;
+	uint64_t tokens = bucket->tokens + (now - bucket->last) * limit->rate;
+	bucket->tokens = tokens > cap ? cap : tokens;
+	bucket->last = now;
+
+	if (bucket->tokens < 1000) return false;
+	bucket->tokens -= 1000;
+	return true;
+}
+
+static int verb_index(const char *verb) {
+	if (!verb) return -1;
+	if (strcmp(verb, "/rank") == 0) return RATE_QUERY;
+	for (int i = 0; i < RATE_VERB_COUNT; i++) {
+		if (strcmp(verb, verb_limits[i].verb) == 0) return i;
+	}
+	return -1;
+}
+
+enum rate_verdict rate_check(Rate_State *state, const char *verb, uint64_t now) {
+	if (conn_limit.rate == 0) return RATE_OK;
+
+	// Seau de la connexion d'abord : même une commande inconnue ou illisible le vide
+	bool allowed = take(&state->conn, &conn_limit, now);
+	int index = verb_index(verb);
+	if (allowed && index >= 0) allowed = take(&state->verbs[index], &verb_limits[index].limit, now);
+	if (allowed) return RATE_OK;
+
+	if (now - state->last_strike > RATE_STRIKE_WINDOW_MS) state->strikes = 0;
+	state->strikes++;
+	state->last_strike = now;
+
+	if (state->strikes >= RATE_KICK_STRIKES) {
+		stats.kicked++;
+		return RATE_KICK;
+	}
+	if (state->strikes % RATE_DELAY_STRIKES == 0) {
+		state->paused_until = now + (uint64_t)RATE_DELAY_MS * (state->strikes / RATE_DELAY_STRIKES);
+		state->last_strike = state->paused_until; // La suspension ne compte pas comme une accalmie
+		stats.delayed++;
+		return RATE_DELAY;
+	}
+	stats.dropped++;
+	return RATE_DROP;
+}
+
+const Rate_Stats *rate_stats(void) {
+	return &stats;
+}
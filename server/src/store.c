@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#include "../include/store.h"
+#include "../include/buffer.h"
+#include "../include/utils.h"
+#include "../include/config.h"
+#include "../include/color.h"
+
+typedef struct Score_Entry {
+	char username[MAX_USERNAME];
+	int score;
+	int games;
+	struct Score_Entry *next;
+} Score_Entry;
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_t writer;
+	bool running;
+
+	// Index en mémoire (clé : nom d'utilisateur sans casse), protégé par lock
+	Score_Entry **buckets;
+	size_t bucket_count;
+	size_t entry_count;
+
+	// Enregistrements en attente d'écriture, protégés par lock
+	Buffer pending_scores;
+	Buffer pending_matches;
+
+	// Propres au thread d'écriture
+	char scores_path[STORE_MAX_PATH];
+	char matches_path[STORE_MAX_PATH];
+	int scores_fd;
+	int matches_fd;
+	size_t records_since_compaction;
+} store = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.scores_fd = -1,
+	.matches_fd = -1,
+};
+
+static Score_Entry *find_entry(const char *username) {
+	if (!store.bucket_count) return NULL;
+	Score_Entry *e = store.buckets[hash_username(username) % store.bucket_count];
+	while (e && strcasecmp(e->username, username) != 0) e = e->next;
+	return e;
+}
+
+static void rehash(size_t new_count) {
+	Score_Entry **buckets = calloc(new_count, sizeof(Score_Entry *));
+	if (!buckets) return;
+
+	for (size_t i = 0; i < store.bucket_count; i++) {
+		Score_Entry *e = store.buckets[i];
+		while (e) {
+			Score_Entry *next = e->next;
+			size_t b = hash_username(e->username) % new_count;
+			e->next = buckets[b];
+			buckets[b] = e;
+			e = next;
+		}
+	}
+
+	free(store.buckets);
+	store.buckets = buckets;
+	store.bucket_count = new_count;
+}
+
+static Score_Entry *get_or_create_entry(const char *username) {
+	Score_Entry *e = find_entry(username);
+	if (e) return e;
+
+	if (store.entry_count >= store.bucket_count) {
+		rehash(store.bucket_count ? store.bucket_count * 2 : 64);
+		if (!store.bucket_count) return NULL;
+	}
+
+	e = calloc(1, sizeof(Score_Entry));
+	if (!e) return NULL;
+	strncpy(e->username, username, MAX_USERNAME - 1);
+
+	size_t b = hash_username(username) % store.bucket_count;
+	e->next = store.buckets[b];
+	store.buckets[b] = e;
+	store.entry_count++;
+	return e;
+}
+
+/*
+ * Relecture de scores.log :
+ *   T<TAB>nom<TAB>total<TAB>parties   (instantané écrit par le compactage)
+ *   S<TAB>nom<TAB>gain                (une ligne par joueur et par partie)
+ */
+static void load_scores(FILE *file) {
+	char line[BUFFER_SIZE];
+	while (fgets(line, sizeof(line), file)) {
+		line[strcspn(line, "\n")] = '\0';
+		char *saveptr = NULL;
+		char *kind = strtok_r(line, "\t", &saveptr);
+		char *username = strtok_r(NULL, "\t", &saveptr);
+		char *value = strtok_r(NULL, "\t", &saveptr);
+		if (!kind || !username || !value) continue;
+
+		Score_Entry *e = get_or_create_entry(username);
+		if (!e) continue;
+
+		if (kind[0] == 'T') {
+			char *games = strtok_r(NULL, "\t", &saveptr);
+			e->score = atoi(value);
+			e->games = games ? atoi(games) : 0;
+		} else if (kind[0] == 'S') {
+			e->score += atoi(value);
+			e->games++;
+		}
+		store.records_since_compaction++;
+	}
+}
+
+static void write_all(int fd, const char *data, size_t len) {
+	while (len > 0) {
+		ssize_t n = write(fd, data, len);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			perror("store write");
+			return;
+		}
+		data += n;
+		len -= n;
+	}
+}
+
+// Instantané des totaux, sérialisé sous le verrou (mémoire uniquement)
+static void snapshot_scores(Buffer *out) {
+	char line[BUFFER_SIZE];
+	for (size_t i = 0; i < store.bucket_count; i++) {
+		for (Score_Entry *e = store.buckets[i]; e; e = e->next) {
+			int len = snprintf(line, sizeof(line), "T\t%s\t%d\t%d\n", e->username, e->score, e->games);
+			buffer_append(out, line, len);
+		}
+	}
+}
+
+// Réécrit scores.log à partir de l'instantané (fichier temporaire puis rename atomique)
+static void compact_scores(const Buffer *snapshot) {
+	char tmp_path[sizeof(store.scores_path) + 8];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", store.scores_path);
+
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		perror("store compaction");
+		return;
+	}
+	write_all(fd, snapshot->data, snapshot->len);
+	fdatasync(fd);
+
+	if (rename(tmp_path, store.scores_path) < 0) {
+		perror("store compaction");
+		close(fd);
+		return;
+	}
+
+	// Le descripteur du fichier temporaire devient le journal courant
+	close(store.scores_fd);
+	store.scores_fd = fd;
+	lseek(fd, 0, SEEK_END);
+}
+
+static void *writer_main(void *arg) {
+	(void)arg;
+	Buffer scores = {0}, matches = {0}, snapshot = {0};
+
+	pthread_mutex_lock(&store.lock);
+	while (true) {
+		// Réveil périodique : tout ce qui est arrivé entretemps part en une écriture groupée
+		if (store.running && !store.pending_scores.len && !store.pending_matches.len) {
+			struct timespec deadline;
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += STORE_FLUSH_INTERVAL;
+			pthread_cond_timedwait(&store.wake, &store.lock, &deadline);
+			if (store.running) continue;
+		}
+
+		// Échange des tampons : la boucle d'événements n'attend jamais le disque
+		Buffer tmp = scores;
+		scores = store.pending_scores;
+		store.pending_scores = tmp;
+		tmp = matches;
+		matches = store.pending_matches;
+		store.pending_matches = tmp;
+
+		bool compact = store.records_since_compaction >= STORE_COMPACT_MIN &&
+				store.records_since_compaction >= 2 * store.entry_count;
+		if (compact) {
+			snapshot.len = 0;
+			snapshot_scores(&snapshot);
+			store.records_since_compaction = 0;
+		}
+		bool stopping = !store.running;
+		pthread_mutex_unlock(&store.lock);
+
+		if (matches.len) {
+			write_all(store.matches_fd, matches.data, matches.len);
+			fdatasync(store.matches_fd);
+		}
+		if (compact) {
+			// Les variations en attente sont déjà comprises dans l'instantané
+			compact_scores(&snapshot);
+		} else if (scores.len) {
+			write_all(store.scores_fd, scores.data, scores.len);
+			fdatasync(store.scores_fd);
+		}
+		scores.len = 0;
+		matches.len = 0;
+
+		pthread_mutex_lock(&store.lock);
+		if (stopping && !store.pending_scores.len && !store.pending_matches.len) break;
+	}
+	pthread_mutex_unlock(&store.lock);
+
+	buffer_free(&scores);
+	buffer_free(&matches);
+	buffer_free(&snapshot);
+	return NULL;
+}
+
+bool store_open(const char *dir) {
+	if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+		perror("store_open");
+		return false;
+	}
+
+	snprintf(store.scores_path, sizeof(store.scores_path), "%s/scores.log", dir);
+	snprintf(store.matches_path, sizeof(store.matches_path), "%s/matches.log", dir);
+
+	FILE *file = fopen(store.scores_path, "r");
+	if (file) {
+		load_scores(file);
+		fclose(file);
+	}
+
+	store.scores_fd = open(store.scores_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	store.matches_fd = open(store.matches_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (store.scores_fd < 0 || store.matches_fd < 0) {
+		perror("store_open");
+		return false;
+	}
+
+	store.running = true;
+	if (pthread_create(&store.writer, NULL, writer_main, NULL) != 0) {
+		store.running = false;
+		return false;
+	}
+
+	printf(ANSI_COLOR_GREEN "Historique chargé depuis " ANSI_STYLE_BOLD "%s" ANSI_RESET_ALL ANSI_COLOR_GREEN " : %zu joueurs" ANSI_RESET_ALL "\n", dir, store.entry_count);
+	return true;
+}
+
+int store_get_score(const char *username) {
+	pthread_mutex_lock(&store.lock);
+	Score_Entry *e = find_entry(username);
+	int score = e ? e->score : 0;
+	pthread_mutex_unlock(&store.lock);
+	return score;
+}
+
+// Parcourt les totaux connus (chargement du classement au démarrage)
+void store_foreach(void (*fn)(const char *username, int score, int games, void *ctx), void *ctx) {
+	pthread_mutex_lock(&store.lock);
+	for (size_t i = 0; i < store.bucket_count; i++) {
+		for (Score_Entry *e = store.buckets[i]; e; e = e->next) {
+			fn(e->username, e->score, e->games, ctx);
+		}
+	}
+	pthread_mutex_unlock(&store.lock);
+}
+
+/*
+ * Met à jour l'index en mémoire et met les enregistrements en file.
+ * Appelé depuis la boucle d'événements : aucune entrée/sortie ici.
+ */
+void store_record_match(const Match_Result *result) {
+	if (!store.running) return;
+
+	char line[BUFFER_SIZE];
+	int len;
+
+	pthread_mutex_lock(&store.lock);
+
+	len = snprintf(line, sizeof(line), "M\t%ld\t%s\t%s\t%s\t%s\t%d\t%d",
+			(long)result->finished_at, result->impostor, result->impostor_word, result->common_word,
+			result->accused ? result->accused : "-", result->caught, result->player_count);
+	buffer_append(&store.pending_matches, line, len);
+
+	for (int i = 0; i < result->player_count; i++) {
+		const char *username = result->usernames[i];
+		if (!username || !username[0]) continue;
+
+		len = snprintf(line, sizeof(line), "\t%s\t%d", username, result->gains[i]);
+		buffer_append(&store.pending_matches, line, len);
+
+		len = snprintf(line, sizeof(line), "S\t%s\t%d\n", username, result->gains[i]);
+		buffer_append(&store.pending_scores, line, len);
+
+		Score_Entry *e = get_or_create_entry(username);
+		if (e) {
+			e->score += result->gains[i];
+			e->games++;
+		}
+		store.records_since_compaction++;
+	}
+	buffer_append(&store.pending_matches, "\n", 1);
+
+	pthread_mutex_unlock(&store.lock);
+}
+
+// Vide la file d'écriture puis libère l'index
+void store_close(void) {
+	if (!store.running) return;
+
+	pthread_mutex_lock(&store.lock);
+	store.running = false;
+	pthread_cond_signal(&store.wake);
+	pthread_mutex_unlock(&store.lock);
+	pthread_join(store.writer, NULL);
+
+	close(store.scores_fd);
+	close(store.matches_fd);
+	buffer_free(&store.pending_scores);
+	buffer_free(&store.pending_matches);
+
+	for (size_t i = 0; i < store.bucket_count; i++) {
+		Score_Entry *e = store.buckets[i];
+		while (e) {
+			Score_Entry *next = e->next;
+			free(e);
+			e = next;
+		}
+	}
+	free(store.buckets);
+	store.buckets = NULL;
+	store.bucket_count = 0;
+	store.entry_count = 0;
+}
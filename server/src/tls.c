@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <errno.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "../include/tls.h"
+#include "../include/utils.h"
+#include "../include/color.h"
+
+static SSL_CTX *ctx = NULL;
+
+bool tls_init(const char *cert_file, const char *key_file) {
+	ctx = SSL_CTX_new(TLS_server_method());
+	if (!ctx) {
+		ERR_print_errors_fp(stderr);
+		return false;
+	}
+
+	SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+	if (SSL_CTX_use_certificate_chain_file(ctx, cert_file) != 1 ||
+		SSL_CTX_use_PrivateKey_file(ctx, key_file, SSL_FILETYPE_PEM) != 1 ||
+		SSL_CTX_check_private_key(ctx) != 1) {
+		ERR_print_errors_fp(stderr);
+		SSL_CTX_free(ctx);
+		ctx = NULL;
+		return false;
+	}
+
+	// Écritures partielles : la file de sortie du joueur garde le reste
+	SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_RELEASE_BUFFERS);
+
+	// Reprise de session : cache serveur (TLS 1.2) et tickets sans état (TLS 1.2 et 1.3)
+	static const unsigned char session_ctx[] = "imposteur";
+	SSL_CTX_set_session_id_context(ctx, session_ctx, sizeof(session_ctx) - 1);
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+	SSL_CTX_set_num_tickets(ctx, 2);
+
+#ifdef SSL_OP_ENABLE_KTLS
+	// Chiffrement délégué au noyau quand il le supporte (module tls chargé)
+	SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+
+	return true;
+}
+
+bool tls_enabled(void) {
+	return ctx != NULL;
+}
+
+bool tls_attach(Player *player) {
+	player->ssl = SSL_new(ctx);
+	if (!player->ssl) return false;
+
+	if (!SSL_set_fd(player->ssl, player->fd)) {
+		SSL_free(player->ssl);
+		player->ssl = NULL;
+		return false;
+	}
+	SSL_set_accept_state(player->ssl);
+	player->tls_ready = false;
+	return true;
+}
+
+// Traduit une erreur OpenSSL en errno : EAGAIN pour une opération à reprendre
+static int tls_error(Player *player, int ret) {
+	switch (SSL_get_error(player->ssl, ret)) {
+		case SSL_ERROR_WANT_READ:
+			return EAGAIN;
+		case SSL_ERROR_WANT_WRITE:
+			player->tls_want_write = true;
+			return EAGAIN;
+		case SSL_ERROR_ZERO_RETURN:
+			return 0;
+		default:
+			ERR_clear_error();
+			return EIO;
+	}
+}
+
+enum tls_status tls_handshake(Player *player) {
+	player->tls_want_write = false;
+	int ret = SSL_do_handshake(player->ssl);
+	if (ret != 1) {
+		return tls_error(player, ret) == EAGAIN ? TLS_PENDING : TLS_ERROR;
+	}
+
+	player->tls_ready = true;
+
+	char details[BUFFER_SIZE];
+	snprintf(details, sizeof(details), "TLS established (%s, %s%s).", SSL_get_version(player->ssl),
+			SSL_session_reused(player->ssl) ? "resumed" : "full handshake",
+#ifdef SSL_OP_ENABLE_KTLS
+			BIO_get_ktls_send(SSL_get_wbio(player->ssl)) ? ", kTLS" : ""
+#else
+			""
+#endif
+			);
+	log_message(ANSI_COLOR_RED ANSI_STYLE_BOLD "Unknown", details, player->addr);
+	return TLS_DONE;
+}
+
+ssize_t tls_read(Player *player, void *buf, size_t len) {
+	player->tls_want_write = false;
+	int ret = SSL_read(player->ssl, buf, (int)len);
+	if (ret > 0) return ret;
+
+	int err = tls_error(player, ret);
+	if (err == 0) return 0;
+	errno = err;
+	return -1;
+}
+
+ssize_t tls_write(Player *player, const void *buf, size_t len) {
+	player->tls_want_write = false;
+	int ret = SSL_write(player->ssl, buf, (int)len);
+	if (ret > 0) return ret;
+
+	int err = tls_error(player, ret);
+	errno = err ? err : EPIPE;
+	return -1;
+}
+
+// Données déjà déchiffrées par OpenSSL mais pas encore lues (invisibles pour poll)
+bool tls_pending(Player *player) {
+	return player->ssl && SSL_pending(player->ssl) > 0;
+}
+
+void tls_detach(Player *player) {
+	if (!player->ssl) return;
+	if (player->tls_ready) SSL_shutdown(player->ssl);
+	SSL_free(player->ssl);
+	player->ssl = NULL;
+}
+
+void tls_cleanup(void) {
+	SSL_CTX_free(ctx);
+	ctx = NULL;
+}
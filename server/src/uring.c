@@ -0,0 +1,488 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "../include/uring.h"
+
+// Nature de l'opération, dans les 3 bits de poids faible de user_data
+enum uring_op { OP_ACCEPT = 1, OP_RECV, OP_SEND, OP_CANCEL, OP_RECV_ONCE };
+#define OP_MASK 7
+
+// Socket d'écoute ; son indice accompagne l'accept multishot dans user_data
+typedef struct Uring_Listener {
+	int fd;
+	enum transport transport;
+} Uring_Listener;
+
+static struct {
+	bool enabled;
+	bool multishot;        // Recv multishot (6.0) : à défaut, un recv par réception
+	int fd;
+
+	// File de soumission (partagée avec le noyau)
+	void *sq_ptr;
+	size_t sq_len;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	struct io_uring_sqe *sqes;
+	size_t sqes_len;
+	unsigned sq_entries;
+	unsigned sqe_tail;     // Entrées préparées, publiées au prochain io_uring_enter
+	unsigned to_submit;
+
+	// File de complétion
+	void *cq_ptr;
+	size_t cq_len;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	// Anneau de tampons de réception (groupe 0)
+	struct io_uring_buf_ring *buf_ring;
+	size_t buf_ring_len;
+	char *buf_base;
+	unsigned short buf_tail;
+
+	// Joueurs qui ont des données à envoyer ce tour-ci
+	Player **dirty;
+	size_t dirty_count, dirty_cap;
+
+	Uring_Listener listeners[2];
+	int listener_count;
+} ring = { .fd = -1 };
+
+static int sys_setup(unsigned entries, struct io_uring_params *params) {
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_enter(unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg, size_t argsz) {
+	return (int)syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int sys_register(unsigned opcode, void *arg, unsigned nr_args) {
+	return (int)syscall(__NR_io_uring_register, ring.fd, opcode, arg, nr_args);
+}
+
+static uint64_t tag(void *ptr, enum uring_op op) {
+	return (uint64_t)(uintptr_t)ptr | op;
+}
+
+// Publie les entrées préparées et les soumet au noyau
+static int submit(unsigned min_complete, unsigned flags, const void *arg, size_t argsz) {
+	__atomic_store_n(ring.sq_tail, ring.sqe_tail, __ATOMIC_RELEASE);
+	unsigned count = ring.to_submit;
+	int ret = sys_enter(count, min_complete, flags, arg, argsz);
+	if (ret < 0) return -errno;
+	ring.to_submit -= ret < (int)count ? ret : count;
+	return ret;
+}
+
+static struct io_uring_sqe *get_sqe(void) {
+	// File pleine : on soumet tout de suite pour faire de la place
+	if (ring.sqe_tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) >= ring.sq_entries) {
+		submit(0, 0, NULL, 0);
+		if (ring.sqe_tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) >= ring.sq_entries) return NULL;
+	}
+
+	unsigned index = ring.sqe_tail & *ring.sq_mask;
+	struct io_uring_sqe *sqe = &ring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	ring.sq_array[index] = index;
+	ring.sqe_tail++;
+	ring.to_submit++;
+	return sqe;
+}
+
+// Rend un tampon au noyau une fois ses données consommées
+static void recycle_buffer(unsigned short bid) {
+	struct io_uring_buf *buf = &ring.buf_ring->bufs[ring.buf_tail & (URING_BUF_COUNT - 1)];
+	buf->addr = (uint64_t)(uintptr_t)(ring.buf_base + (size_t)bid * URING_BUF_SIZE);
+	buf->len = URING_BUF_SIZE;
+	buf->bid = bid;
+	ring.buf_tail++;
+	__atomic_store_n(&ring.buf_ring->tail, ring.buf_tail, __ATOMIC_RELEASE);
+}
+
+static void unmap_rings(void) {
+	if (ring.sqes) munmap(ring.sqes, ring.sqes_len);
+	if (ring.cq_ptr && ring.cq_ptr != ring.sq_ptr) munmap(ring.cq_ptr, ring.cq_len);
+	if (ring.sq_ptr) munmap(ring.sq_ptr, ring.sq_len);
+	if (ring.buf_ring) munmap(ring.buf_ring, ring.buf_ring_len);
+	free(ring.buf_base);
+	if (ring.fd >= 0) close(ring.fd);
+	ring.sqes = NULL;
+	ring.sq_ptr = ring.cq_ptr = NULL;
+	ring.buf_ring = NULL;
+	ring.buf_base = NULL;
+	ring.fd = -1;
+}
+
+// Prochaine complétion (attendue si besoin) ; faux si io_uring_enter échoue
+static bool next_cqe(struct io_uring_cqe *out) {
+	unsigned head = *ring.cq_head;
+	while (head == __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+		int ret = submit(1, IORING_ENTER_GETEVENTS, NULL, 0);
+		if (ret < 0 && ret != -EINTR) return false;
+	}
+	*out = ring.cqes[head & *ring.cq_mask];
+	__atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+	if (out->flags & IORING_CQE_F_BUFFER) recycle_buffer(out->flags >> IORING_CQE_BUFFER_SHIFT);
+	return true;
+}
+
+/*
+ * Essai d'un recv multishot sur une paire de sockets : un noyau qui ne le connaît
+ * pas répond -EINVAL (ou ignore le drapeau, sans IORING_CQE_F_MORE). La fermeture
+ * de l'autre extrémité termine ensuite le multishot (complétion à 0).
+ */
+static bool probe_multishot_recv(void) {
+	int sv[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) return false;
+
+	bool supported = false;
+	struct io_uring_sqe *sqe = get_sqe();
+	if (sqe) {
+		sqe->opcode = IORING_OP_RECV;
+		sqe->fd = sv[0];
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = 0;
+		sqe->user_data = 0;
+
+		struct io_uring_cqe cqe;
+		if (write(sv[1], "?", 1) == 1 && next_cqe(&cqe)) {
+			supported = cqe.res > 0 && (cqe.flags & IORING_CQE_F_MORE);
+			if (cqe.flags & IORING_CQE_F_MORE) {
+				close(sv[1]);
+				sv[1] = -1;
+				while (next_cqe(&cqe) && (cqe.flags & IORING_CQE_F_MORE)) {}
+			}
+		}
+	}
+
+	if (sv[1] >= 0) close(sv[1]);
+	close(sv[0]);
+	return supported;
+}
+
+bool uring_init(void) {
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	ring.fd = sys_setup(URING_ENTRIES, &params);
+	if (ring.fd < 0) return false;
+
+	// Délai d'attente passé à io_uring_enter (5.11) et anneaux dans un seul mmap
+	if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+		unmap_rings();
+		return false;
+	}
+
+	ring.sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring.cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (ring.cq_len > ring.sq_len) ring.sq_len = ring.cq_len;
+	ring.cq_len = ring.sq_len;
+
+	ring.sq_ptr = mmap(NULL, ring.sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	if (ring.sq_ptr == MAP_FAILED) {
+		ring.sq_ptr = NULL;
+		unmap_rings();
+		return false;
+	}
+	ring.cq_ptr = ring.sq_ptr;
+
+	ring.sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring.sqes = mmap(NULL, ring.sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+	if (ring.sqes == MAP_FAILED) {
+		ring.sqes = NULL;
+		unmap_rings();
+		return false;
+	}
+
+	char *sq = ring.sq_ptr;
+	ring.sq_head = (unsigned *)(sq + params.sq_off.head);
+	ring.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring.sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+	ring.sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring.sq_entries = params.sq_entries;
+	ring.sqe_tail = *ring.sq_tail;
+
+	char *cq = ring.cq_ptr;
+	ring.cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring.cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+	ring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+	// Anneau de tampons fournis (5.19) : le recv multishot y choisit ses tampons
+	ring.buf_ring_len = URING_BUF_COUNT * sizeof(struct io_uring_buf);
+	ring.buf_ring = mmap(NULL, ring.buf_ring_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ring.buf_ring == MAP_FAILED) {
+		ring.buf_ring = NULL;
+		unmap_rings();
+		return false;
+	}
+	ring.buf_base = malloc((size_t)URING_BUF_COUNT * URING_BUF_SIZE);
+	if (!ring.buf_base) {
+		unmap_rings();
+		return false;
+	}
+
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t)(uintptr_t)ring.buf_ring;
+	reg.ring_entries = URING_BUF_COUNT;
+	reg.bgid = 0;
+	if (sys_register(IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		unmap_rings();
+		return false;
+	}
+
+	ring.buf_tail = 0;
+	for (unsigned short bid = 0; bid < URING_BUF_COUNT; bid++) recycle_buffer(bid);
+
+	// Le reste (5.19) ne garantit pas le recv multishot (6.0) : sans lui, poll()
+	if (!probe_multishot_recv()) {
+		unmap_rings();
+		return false;
+	}
+
+	ring.enabled = true;
+	ring.multishot = true;
+	return true;
+}
+
+bool uring_enabled(void) {
+	return ring.enabled;
+}
+
+static void arm_accept(Uring_Listener *listener) {
+	struct io_uring_sqe *sqe = get_sqe();
+	if (!sqe) return;
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = listener->fd;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data = (uint64_t)(listener - ring.listeners) << 3 | OP_ACCEPT;
+}
+
+void uring_listen(int fd, enum transport transport) {
+	if (ring.listener_count >= 2) return;
+	Uring_Listener *listener = &ring.listeners[ring.listener_count++];
+	listener->fd = fd;
+	listener->transport = transport;
+	arm_accept(listener);
+}
+
+void uring_recv(Player *p) {
+	struct io_uring_sqe *sqe = get_sqe();
+	if (!sqe) return;
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = p->fd;
+	sqe->ioprio = ring.multishot ? IORING_RECV_MULTISHOT : 0;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = 0;
+	sqe->user_data = tag(p, ring.multishot ? OP_RECV : OP_RECV_ONCE);
+	p->uring_ops++;
+}
+
+static void prep_send(Player *p) {
+	struct io_uring_sqe *sqe = get_sqe();
+	if (!sqe) {
+		p->sending.len = 0;
+		return;
+	}
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = p->fd;
+	sqe->addr = (uint64_t)(uintptr_t)p->sending.data;
+	sqe->len = p->sending.len;
+	sqe->msg_flags = MSG_NOSIGNAL;
+	sqe->user_data = tag(p, OP_SEND);
+	p->uring_ops++;
+}
+
+// Tout ce qui attend dans p->out part d'un bloc : la file passe dans p->sending,
+// qui ne bouge plus tant que le noyau la lit
+static void start_send(Player *p) {
+	if (p->uring_closing || p->sending.len > 0 || p->out.len == 0) return;
+
+	Buffer swap = p->sending;
+	p->sending = p->out;
+	p->out = swap;
+	p->out.len = 0;
+	prep_send(p);
+}
+
+// Un seul envoi en vol par joueur ; les messages suivants s'accumulent dans p->out
+void uring_send(Player *p) {
+	if (p->uring_closing || p->uring_dirty) return;
+
+	if (ring.dirty_count == ring.dirty_cap) {
+		size_t cap = ring.dirty_cap ? ring.dirty_cap * 2 : 16;
+		Player **dirty = realloc(ring.dirty, cap * sizeof(Player *));
+		if (!dirty) return;
+		ring.dirty = dirty;
+		ring.dirty_cap = cap;
+	}
+	ring.dirty[ring.dirty_count++] = p;
+	p->uring_dirty = true;
+}
+
+void uring_release(Player *p) {
+	if (p->uring_closing) return;
+	p->uring_closing = true;
+
+	if (p->uring_dirty) {
+		for (size_t i = 0; i < ring.dirty_count; i++) {
+			if (ring.dirty[i] == p) {
+				ring.dirty[i] = ring.dirty[--ring.dirty_count];
+				break;
+			}
+		}
+		p->uring_dirty = false;
+	}
+
+	// Dernier message (refus, expulsion) : envoyé directement, sans attendre de complétion
+	if (p->sending.len == 0 && p->out.len > 0) send(p->fd, p->out.data, p->out.len, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+	// Le recv multishot et un éventuel envoi se terminent avec -ECANCELED
+	shutdown(p->fd, SHUT_RDWR);
+	struct io_uring_sqe *sqe = get_sqe();
+	if (!sqe) return;
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = p->fd;
+	sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+	sqe->user_data = tag(NULL, OP_CANCEL);
+}
+
+// Dernière opération terminée d'un joueur retiré : plus rien ne pointe sur lui
+static void release_if_idle(Player *p) {
+	if (p->uring_closing && p->uring_ops == 0) free_player(p);
+}
+
+static void complete_recv(Player *p, struct io_uring_cqe *cqe, bool multishot, const Uring_Handlers *handlers) {
+	bool more = cqe->flags & IORING_CQE_F_MORE;
+	if (!more) p->uring_ops--;
+
+	if (cqe->flags & IORING_CQE_F_BUFFER) {
+		unsigned short bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+		if (cqe->res > 0 && !p->uring_closing) {
+			handlers->received(p, ring.buf_base + (size_t)bid * URING_BUF_SIZE, cqe->res);
+		}
+		recycle_buffer(bid);
+	}
+
+	// Multishot refusé malgré la sonde (noyau, seccomp...) : le moteur passe au recv simple, le client reste
+	bool unsupported = multishot && cqe->res == -EINVAL;
+	if (unsupported && ring.multishot) {
+		fprintf(stderr, "io_uring : recv multishot refusé, un recv par réception\n");
+		ring.multishot = false;
+	}
+
+	if (!p->uring_closing) {
+		if (unsupported) {
+			uring_recv(p);
+		} else if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS)) {
+			handlers->closed(p);
+		} else if (!more) {
+			// Multishot interrompu (plus de tampons libres...) : les données attendent dans la socket
+			uring_recv(p);
+		}
+	}
+	release_if_idle(p);
+}
+
+static void complete_send(Player *p, struct io_uring_cqe *cqe) {
+	p->uring_ops--;
+
+	if (!p->uring_closing) {
+		if (cqe->res < 0) {
+			// Erreur fatale : la déconnexion sera constatée par le recv
+			p->sending.len = 0;
+			p->out.len = 0;
+		} else {
+			buffer_consume(&p->sending, cqe->res);
+			if (p->sending.len > 0) {
+				prep_send(p); // Envoi partiel : on renvoie la suite
+			} else if (p->out.len > 0) {
+				uring_send(p);
+			}
+		}
+	}
+	release_if_idle(p);
+}
+
+static void complete_accept(Uring_Listener *listener, struct io_uring_cqe *cqe, const Uring_Handlers *handlers) {
+	if (cqe->res >= 0) {
+		Player *p = handlers->accepted(cqe->res, listener->transport);
+		if (p) uring_recv(p);
+	} else if ((cqe->res == -EMFILE || cqe->res == -ENFILE) && handlers->shed(listener->fd, listener->transport)) {
+		// Le client en tête de file a été refusé, l'accept reprend
+	} else if (cqe->res != -ECANCELED) {
+		fprintf(stderr, "accept: %s\n", strerror(-cqe->res));
+	}
+	if (!(cqe->flags & IORING_CQE_F_MORE)) arm_accept(listener);
+}
+
+int uring_wait(int timeout_ms, const Uring_Handlers *handlers) {
+	for (size_t i = 0; i < ring.dirty_count; i++) {
+		Player *p = ring.dirty[i];
+		p->uring_dirty = false;
+		start_send(p);
+	}
+	ring.dirty_count = 0;
+
+	struct __kernel_timespec ts = { .tv_sec = timeout_ms / 1000, .tv_nsec = (long long)(timeout_ms % 1000) * 1000000 };
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	arg.sigmask_sz = _NSIG / 8;
+	arg.ts = (uint64_t)(uintptr_t)&ts;
+
+	int ret = submit(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) return ret;
+
+	unsigned head = *ring.cq_head;
+	unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+	int count = 0;
+
+	while (head != tail) {
+		struct io_uring_cqe cqe = ring.cqes[head & *ring.cq_mask];
+		head++;
+		// La place est rendue tout de suite : les gestionnaires peuvent préparer d'autres entrées
+		__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+		count++;
+
+		void *ptr = (void *)(uintptr_t)(cqe.user_data & ~(uint64_t)OP_MASK);
+		switch (cqe.user_data & OP_MASK) {
+			case OP_ACCEPT:
+				complete_accept(&ring.listeners[cqe.user_data >> 3], &cqe, handlers);
+				break;
+			case OP_RECV:
+			case OP_RECV_ONCE:
+				complete_recv(ptr, &cqe, (cqe.user_data & OP_MASK) == OP_RECV, handlers);
+				break;
+			case OP_SEND:
+				complete_send(ptr, &cqe);
+				break;
+			default:
+				break;
+		}
+		tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+	}
+	return count;
+}
+
+void uring_cleanup(void) {
+	if (!ring.enabled) return;
+	ring.enabled = false;
+	unmap_rings();
+	free(ring.dirty);
+	ring.dirty = NULL;
+	ring.dirty_count = ring.dirty_cap = 0;
+}
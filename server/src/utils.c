@@ -13,21 +13,6 @@
 #define MAX_LINE_LENGTH 1024
 #define MAX_WORDS_PER_LINE 100
 
-void broadcast_message(Player *head, const char *message, Player *ignored_player) {
-	time_t now = time(NULL);
-	char *time_str = ctime(&now);
-	time_str[strlen(time_str) - 1] = '\0';
-
-	while (head) {
-		if(head != ignored_player) {
-			send(head->fd, message, strlen(message), 0);
-		}
-		head = head->next;
-	}
-
-	printf(ANSI_STYLE_BOLD ANSI_COLOR_GREEN "[%s] " ANSI_COLOR_CYAN "Server broadcast a message to everyone > " ANSI_RESET_ALL ANSI_COLOR_YELLOW "%s" ANSI_RESET_ALL, time_str, message);
-}
-
 void log_message(const char *username, const char *message, const char *addr) {
 	time_t now = time(NULL);
 	char *time_str = ctime(&now);
@@ -54,6 +39,14 @@ void to_lowercase(const char *src, char *dest, int max_len) {
 	dest[i] = '\0';  // null-terminate le résultat
 }
 
+size_t hash_username(const char *username) {
+	size_t h = 5381;
+	for (const char *c = username; *c; c++) {
+		h = h * 33 + (unsigned char)tolower((unsigned char)*c);
+	}
+	return h;
+}
+
 Command *parse_input(const char *input) {
     if (!input || input[0] != '/') return NULL;
 
@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../include/websocket.h"
+#include "../include/utils.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_MAX_KEY 64
+
+static uint32_t rol32(uint32_t value, int bits) {
+	return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1 minimal, suffisant pour la clé d'upgrade (entrée < 119 octets)
+static void sha1(const uint8_t *data, size_t len, uint8_t digest[20]) {
+	uint8_t msg[128] = {0};
+	size_t total = len + 9 <= 64 ? 64 : 128;
+	uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+	memcpy(msg, data, len);
+	msg[len] = 0x80;
+	uint64_t bits = (uint64_t)len * 8;
+	for (int i = 0; i < 8; i++) {
+		msg[total - 1 - i] = (uint8_t)(bits >> (8 * i));
+	}
+
+	for (size_t chunk = 0; chunk < total; chunk += 64) {
+		uint32_t w[80];
+		for (int i = 0; i < 16; i++) {
+			const uint8_t *p = msg + chunk + 4 * i;
+			w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+		}
+		for (int i = 16; i < 80; i++) {
+			w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+
+		uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+		for (int i = 0; i < 80; i++) {
+			uint32_t f, k;
+			if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+			else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+			else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+			else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+			uint32_t tmp = rol32(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rol32(b, 30);
+			b = a;
+			a = tmp;
+		}
+		h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+	}
+
+	for (int i = 0; i < 5; i++) {
+		digest[4 * i]     = (uint8_t)(h[i] >> 24);
+		digest[4 * i + 1] = (uint8_t)(h[i] >> 16);
+		digest[4 * i + 2] = (uint8_t)(h[i] >> 8);
+		digest[4 * i + 3] = (uint8_t)h[i];
+	}
+}
+
+static void base64_encode(const uint8_t *data, size_t len, char *out) {
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t o = 0;
+	for (size_t i = 0; i < len; i += 3) {
+		uint32_t v = (uint32_t)data[i] << 16;
+		if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+		if (i + 2 < len) v |= data[i + 2];
+
+		out[o++] = alphabet[(v >> 18) & 0x3F];
+		out[o++] = alphabet[(v >> 12) & 0x3F];
+		out[o++] = i + 1 < len ? alphabet[(v >> 6) & 0x3F] : '=';
+		out[o++] = i + 2 < len ? alphabet[v & 0x3F] : '=';
+	}
+	out[o] = '\0';
+}
+
+// Trame serveur -> client (jamais masquée)
+void ws_encode_frame(Buffer *out, enum ws_opcode opcode, const void *data, size_t len) {
+	uint8_t header[10];
+	size_t header_len = 2;
+
+	header[0] = 0x80 | opcode;
+	if (len < 126) {
+		header[1] = (uint8_t)len;
+	} else if (len <= 0xFFFF) {
+		header[1] = 126;
+		header[2] = (uint8_t)(len >> 8);
+		header[3] = (uint8_t)len;
+		header_len = 4;
+	} else {
+		header[1] = 127;
+		for (int i = 0; i < 8; i++) {
+			header[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+		}
+		header_len = 10;
+	}
+
+	if (!buffer_reserve(out, header_len + len)) return;
+	buffer_append(out, header, header_len);
+	buffer_append(out, data, len);
+}
+
+static void send_control(Player *player, enum ws_opcode opcode, const void *data, size_t len) {
+	Buffer frame = {0};
+	ws_encode_frame(&frame, opcode, data, len);
+	player_write(player, frame.data, frame.len);
+	buffer_free(&frame);
+}
+
+// Recherche insensible à la casse d'un en-tête HTTP, valeur copiée sans espaces
+static bool find_header(const char *request, const char *name, char *value, size_t max_len) {
+	size_t name_len = strlen(name);
+	for (const char *line = strstr(request, "\r\n"); line && line[2]; line = strstr(line + 2, "\r\n")) {
+		line += 2;
+		if (strncasecmp(line, name, name_len) != 0 || line[name_len] != ':') continue;
+
+		const char *start = line + name_len + 1;
+		while (*start == ' ' || *start == '\t') start++;
+		const char *end = strstr(start, "\r\n");
+		while (end > start && (end[-1] == ' ' || end[-1] == '\t')) end--;
+
+		size_t len = end - start;
+		if (len >= max_len) return false;
+		memcpy(value, start, len);
+		value[len] = '\0';
+		return true;
+	}
+	return false;
+}
+
+static enum ws_status process_handshake(Player *player) {
+	char *end = memmem(player->raw.data, player->raw.len, "\r\n\r\n", 4);
+	if (!end) {
+		return player->raw.len > WS_MAX_HANDSHAKE ? WS_ERROR : WS_OK;
+	}
+
+	size_t request_len = end - player->raw.data + 4;
+	char request[WS_MAX_HANDSHAKE + 1];
+	if (request_len > WS_MAX_HANDSHAKE) return WS_ERROR;
+	memcpy(request, player->raw.data, request_len);
+	request[request_len] = '\0';
+	buffer_consume(&player->raw, request_len);
+
+	char upgrade[32], key[WS_MAX_KEY];
+	if (strncmp(request, "GET ", 4) != 0 ||
+		!find_header(request, "Upgrade", upgrade, sizeof(upgrade)) || strcasecmp(upgrade, "websocket") != 0 ||
+		!find_header(request, "Sec-WebSocket-Key", key, sizeof(key))) {
+
+		static const char bad_request[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+		player_write(player, bad_request, sizeof(bad_request) - 1);
+		return WS_ERROR;
+	}
+
+	uint8_t digest[20];
+	char accept_key[32], input[WS_MAX_KEY + sizeof(WS_GUID)];
+	snprintf(input, sizeof(input), "%s" WS_GUID, key);
+	sha1((const uint8_t *)input, strlen(input), digest);
+	base64_encode(digest, sizeof(digest), accept_key);
+
+	char response[BUFFER_SIZE];
+	int len = snprintf(response, sizeof(response),
+		"HTTP/1.1 101 Switching Protocols\r\n"
+		"Upgrade: websocket\r\n"
+		"Connection: Upgrade\r\n"
+		"Sec-WebSocket-Accept: %s\r\n\r\n", accept_key);
+	player_write(player, response, len);
+
+	player->ws_open = true;
+	return WS_OPENED;
+}
+
+/*
+ * Traite les octets WebSocket reçus (player->raw) : handshake HTTP puis trames.
+ * Les données utiles sont ajoutées à player->in, où le découpage en commandes
+ * est le même que pour une connexion TCP.
+ */
+enum ws_status ws_process(Player *player) {
+	enum ws_status status = WS_OK;
+	if (!player->ws_open) {
+		status = process_handshake(player);
+		if (status != WS_OPENED) return status;
+	}
+
+	while (player->raw.len >= 2) {
+		uint8_t *b = (uint8_t *)player->raw.data;
+		bool fin = b[0] & 0x80;
+		int opcode = b[0] & 0x0F;
+		uint64_t len = b[1] & 0x7F;
+		size_t header_len = 2;
+
+		// Bits réservés sans extension négociée, ou trame client non masquée
+		if ((b[0] & 0x70) || !(b[1] & 0x80)) return WS_ERROR;
+
+		if (len == 126) {
+			if (player->raw.len < 4) break;
+			len = (uint64_t)b[2] << 8 | b[3];
+			header_len = 4;
+		} else if (len == 127) {
+			if (player->raw.len < 10) break;
+			len = 0;
+			for (int i = 0; i < 8; i++) len = len << 8 | b[2 + i];
+			header_len = 10;
+		}
+
+		if (len > WS_MAX_PAYLOAD) return WS_ERROR;
+		if ((opcode & 0x8) && (!fin || len > 125)) return WS_ERROR;
+		if (player->raw.len < header_len + 4 + len) break;
+
+		const uint8_t *mask = b + header_len;
+		uint8_t *payload = b + header_len + 4;
+		for (uint64_t i = 0; i < len; i++) {
+			payload[i] ^= mask[i & 3];
+		}
+
+		switch (opcode) {
+			case WS_OP_CONTINUATION:
+			case WS_OP_TEXT:
+			case WS_OP_BINARY:
+				buffer_append(&player->in, payload, len);
+				// Un message texte complet vaut une ligne, même sans '\n' final
+				if (fin && !player->binary && (len == 0 || payload[len - 1] != '\n')) {
+					buffer_append(&player->in, "\n", 1);
+				}
+				break;
+			case WS_OP_PING:
+				send_control(player, WS_OP_PONG, payload, len);
+				break;
+			case WS_OP_PONG:
+				break;
+			case WS_OP_CLOSE:
+				send_control(player, WS_OP_CLOSE, payload, len >= 2 ? 2 : 0);
+				return WS_ERROR;
+			default:
+				return WS_ERROR;
+		}
+
+		buffer_consume(&player->raw, header_len + 4 + len);
+	}
+
+	return status;
+}